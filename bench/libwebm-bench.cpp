@@ -0,0 +1,651 @@
+// BSD 3-Clause License
+
+// Copyright (c) 2025, SCTG Développement
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// libwebm_bench: throughput of the parser and muxer hot paths, built either
+// natively or as a Node-run WASM module (see bench/CMakeLists.txt).
+//
+//   libwebm_bench [--min-time S] [--mux-mb N] [--synthetic-mb N]
+//                 [--synthetic-path P] [file.webm ...]
+//
+// Files default to test/sample.webm and test/av1-opus.webm. --synthetic-mb
+// first muxes a synthetic N MB file to --synthetic-path (multi-GB inputs are
+// read through a file reader instead of memory). Results are printed as one
+// JSON document on stdout.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "mkvmuxer/mkvmuxer.h"
+#include "mkvmuxer/mkvwriter.h"
+#include "mkvparser/mkvparser.h"
+#include "mkvparser/mkvreader.h"
+
+namespace {
+
+// --- Heap accounting ---
+// Every allocation goes through the replaced operator new below, so the
+// peak is measured the same way in the native and the WASM build.
+
+size_t g_heap_in_use = 0;
+size_t g_heap_peak = 0;
+
+constexpr size_t kAllocHeader = alignof(std::max_align_t);
+
+void *countedAlloc(size_t size) {
+  void *block = std::malloc(size + kAllocHeader);
+  if (!block) {
+    return nullptr;
+  }
+  *static_cast<size_t *>(block) = size;
+  g_heap_in_use += size;
+  g_heap_peak = std::max(g_heap_peak, g_heap_in_use);
+  return static_cast<char *>(block) + kAllocHeader;
+}
+
+void countedFree(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  void *block = static_cast<char *>(ptr) - kAllocHeader;
+  g_heap_in_use -= *static_cast<size_t *>(block);
+  std::free(block);
+}
+
+} // namespace
+
+void *operator new(size_t size) {
+  void *ptr = countedAlloc(size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size);
+}
+void operator delete(void *ptr) noexcept { countedFree(ptr); }
+void operator delete[](void *ptr) noexcept { countedFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { countedFree(ptr); }
+
+namespace {
+
+// Inputs above this size are read from disk rather than loaded in memory
+constexpr long long kMemoryInputLimit = 256LL * 1024 * 1024;
+
+// --- Readers and writers ---
+
+// Derives from MkvReader, whose destructor is public, so that memory and
+// file inputs can be owned through the same pointer type
+class BufferReader : public mkvparser::MkvReader {
+public:
+  explicit BufferReader(const std::vector<uint8_t> &data) : data_(data) {}
+
+  int Read(long long pos, long len, unsigned char *buf) override {
+    if (pos < 0 || len < 0 ||
+        static_cast<unsigned long long>(pos + len) > data_.size())
+      return -1;
+    std::memcpy(buf, data_.data() + pos, len);
+    return 0;
+  }
+
+  int Length(long long *total, long long *available) override {
+    *total = *available = static_cast<long long>(data_.size());
+    return 0;
+  }
+
+private:
+  const std::vector<uint8_t> &data_;
+};
+
+// Seekable writer collecting the output in memory
+class VectorWriter : public mkvmuxer::IMkvWriter {
+public:
+  int32_t Write(const void *buf, uint32_t len) override {
+    if (position_ + len > data_.size()) {
+      data_.resize(position_ + len);
+    }
+    std::memcpy(data_.data() + position_, buf, len);
+    position_ += len;
+    return 0;
+  }
+  int64_t Position() const override { return position_; }
+  int32_t Position(int64_t position) override {
+    position_ = static_cast<size_t>(position);
+    return 0;
+  }
+  bool Seekable() const override { return true; }
+  void ElementStartNotify(uint64_t, int64_t) override {}
+
+  size_t size() const { return data_.size(); }
+
+private:
+  std::vector<uint8_t> data_;
+  size_t position_ = 0;
+};
+
+// Seekable writer that only tracks the output size, for outputs too large
+// to keep in memory
+class NullWriter : public mkvmuxer::IMkvWriter {
+public:
+  int32_t Write(const void *, uint32_t len) override {
+    position_ += len;
+    size_ = std::max(size_, position_);
+    return 0;
+  }
+  int64_t Position() const override { return position_; }
+  int32_t Position(int64_t position) override {
+    position_ = position;
+    return 0;
+  }
+  bool Seekable() const override { return true; }
+  void ElementStartNotify(uint64_t, int64_t) override {}
+
+  int64_t size() const { return size_; }
+
+private:
+  int64_t position_ = 0;
+  int64_t size_ = 0;
+};
+
+// An input of the corpus, in memory or read from disk
+struct Input {
+  std::string path;
+  long long size = 0;
+  std::vector<uint8_t> data; // empty for file-backed inputs
+
+  bool inMemory() const { return !data.empty(); }
+
+  std::unique_ptr<mkvparser::MkvReader> open() const {
+    if (inMemory()) {
+      return std::unique_ptr<mkvparser::MkvReader>(new BufferReader(data));
+    }
+    std::unique_ptr<mkvparser::MkvReader> reader(new mkvparser::MkvReader());
+    if (reader->Open(path.c_str()) != 0) {
+      return nullptr;
+    }
+    return reader;
+  }
+};
+
+bool loadInput(const std::string &path, Input &input) {
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  bool ok = fseeko(file, 0, SEEK_END) == 0;
+  input.path = path;
+  input.size = ok ? static_cast<long long>(ftello(file)) : -1;
+  if (ok && input.size > 0 && input.size <= kMemoryInputLimit) {
+    input.data.resize(static_cast<size_t>(input.size));
+    ok = fseeko(file, 0, SEEK_SET) == 0 &&
+         std::fread(input.data.data(), 1, input.data.size(), file) ==
+             input.data.size();
+  }
+  std::fclose(file);
+  return ok && input.size > 0;
+}
+
+// Parse the EBML header and segment headers; nullptr on failure
+std::unique_ptr<mkvparser::Segment> parseSegment(mkvparser::IMkvReader *reader) {
+  long long pos = 0;
+  mkvparser::EBMLHeader header;
+  if (header.Parse(reader, pos) < 0) {
+    return nullptr;
+  }
+  mkvparser::Segment *segment = nullptr;
+  if (mkvparser::Segment::CreateInstance(reader, pos, segment) != 0 ||
+      !segment) {
+    return nullptr;
+  }
+  std::unique_ptr<mkvparser::Segment> owner(segment);
+  if (segment->ParseHeaders() < 0) {
+    return nullptr;
+  }
+  return owner;
+}
+
+// Call |visit| for every frame of a fully loaded segment
+template <typename Visit>
+void forEachFrame(mkvparser::Segment *segment, Visit visit) {
+  for (const mkvparser::Cluster *cluster = segment->GetFirst();
+       cluster && !cluster->EOS(); cluster = segment->GetNext(cluster)) {
+    const mkvparser::BlockEntry *entry = nullptr;
+    if (cluster->GetFirst(entry) < 0) {
+      break;
+    }
+    while (entry && !entry->EOS()) {
+      const mkvparser::Block *block = entry->GetBlock();
+      for (int i = 0; i < block->GetFrameCount(); ++i) {
+        visit(cluster, block, block->GetFrame(i));
+      }
+      if (cluster->GetNext(entry, entry) < 0) {
+        break;
+      }
+    }
+  }
+}
+
+// --- Measurement ---
+
+struct Result {
+  std::string name;
+  std::string file;
+  long long iterations = 0;
+  double seconds = 0;
+  long long bytes = 0;  // payload bytes processed per iteration
+  long long frames = 0; // frames processed per iteration
+  long long ops = 0;    // operations per iteration (headers, seeks)
+  size_t peak_heap = 0;
+  bool ok = true;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Run |body| until at least |min_time| seconds have elapsed. |body| fills
+// the per-iteration counters and returns false on failure.
+Result measure(const std::string &name, const std::string &file,
+               double min_time, const std::function<bool(Result &)> &body) {
+  Result result;
+  result.name = name;
+  result.file = file;
+
+  const size_t heap_base = g_heap_in_use;
+  g_heap_peak = heap_base;
+  const Clock::time_point start = Clock::now();
+  do {
+    if (!body(result)) {
+      result.ok = false;
+      break;
+    }
+    ++result.iterations;
+    result.seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+  } while (result.seconds < min_time);
+  result.peak_heap = g_heap_peak - heap_base;
+  return result;
+}
+
+bool benchParseHeaders(const Input &input, Result &result) {
+  std::unique_ptr<mkvparser::MkvReader> reader = input.open();
+  if (!reader || !parseSegment(reader.get())) {
+    return false;
+  }
+  result.ops = 1;
+  return true;
+}
+
+bool benchDemux(const Input &input, Result &result) {
+  std::unique_ptr<mkvparser::MkvReader> reader = input.open();
+  std::unique_ptr<mkvparser::Segment> segment =
+      reader ? parseSegment(reader.get()) : nullptr;
+  if (!segment || segment->Load() < 0) {
+    return false;
+  }
+
+  std::vector<unsigned char> buffer;
+  long long bytes = 0;
+  long long frames = 0;
+  bool ok = true;
+  forEachFrame(segment.get(), [&](const mkvparser::Cluster *,
+                                  const mkvparser::Block *,
+                                  const mkvparser::Block::Frame &frame) {
+    buffer.resize(static_cast<size_t>(frame.len));
+    ok = ok && frame.Read(reader.get(), buffer.data()) == 0;
+    bytes += frame.len;
+    ++frames;
+  });
+  result.bytes = bytes;
+  result.frames = frames;
+  return ok;
+}
+
+bool benchSeek(const Input &input, Result &result) {
+  constexpr int kSeeks = 200;
+
+  std::unique_ptr<mkvparser::MkvReader> reader = input.open();
+  std::unique_ptr<mkvparser::Segment> segment =
+      reader ? parseSegment(reader.get()) : nullptr;
+  if (!segment || segment->Load() < 0) {
+    return false;
+  }
+
+  // Seek on the first video track, or the first track
+  const mkvparser::Tracks *tracks = segment->GetTracks();
+  const mkvparser::Track *track = nullptr;
+  for (unsigned long i = 0; tracks && i < tracks->GetTracksCount(); ++i) {
+    const mkvparser::Track *candidate = tracks->GetTrackByIndex(i);
+    if (candidate && (!track || candidate->GetType() ==
+                                    mkvparser::Track::kVideo)) {
+      track = candidate;
+      if (track->GetType() == mkvparser::Track::kVideo) {
+        break;
+      }
+    }
+  }
+  const long long duration = segment->GetDuration();
+  if (!track || duration <= 0) {
+    return false;
+  }
+
+  // Fixed pseudo-random targets so that runs are comparable
+  uint32_t state = 12345;
+  const mkvparser::Cues *cues = segment->GetCues();
+  for (int i = 0; i < kSeeks; ++i) {
+    state = state * 1664525u + 1013904223u;
+    const long long time_ns = static_cast<long long>(
+        static_cast<double>(state) / 4294967296.0 * duration);
+
+    const mkvparser::CuePoint *cue = nullptr;
+    const mkvparser::CuePoint::TrackPosition *position = nullptr;
+    const mkvparser::BlockEntry *entry = nullptr;
+    if (cues && cues->Find(time_ns, track, cue, position)) {
+      entry = cues->GetBlock(cue, position);
+    }
+    if (!entry && track->Seek(time_ns, entry) < 0) {
+      return false;
+    }
+  }
+  result.ops = kSeeks;
+  return true;
+}
+
+bool benchRemux(const Input &input, Result &result) {
+  std::unique_ptr<mkvparser::MkvReader> reader = input.open();
+  std::unique_ptr<mkvparser::Segment> segment =
+      reader ? parseSegment(reader.get()) : nullptr;
+  if (!segment || segment->Load() < 0) {
+    return false;
+  }
+
+  VectorWriter memory_writer;
+  NullWriter null_writer;
+  mkvmuxer::IMkvWriter *writer = input.inMemory()
+                                     ? static_cast<mkvmuxer::IMkvWriter *>(
+                                           &memory_writer)
+                                     : &null_writer;
+  mkvmuxer::Segment muxer;
+  if (!muxer.Init(writer)) {
+    return false;
+  }
+  muxer.set_mode(mkvmuxer::Segment::kFile);
+
+  // Copy the video and audio tracks, keeping their numbers
+  const mkvparser::Tracks *tracks = segment->GetTracks();
+  for (unsigned long i = 0; tracks && i < tracks->GetTracksCount(); ++i) {
+    const mkvparser::Track *track = tracks->GetTrackByIndex(i);
+    if (!track) {
+      continue;
+    }
+    uint64_t number = 0;
+    if (track->GetType() == mkvparser::Track::kVideo) {
+      const auto *video = static_cast<const mkvparser::VideoTrack *>(track);
+      number = muxer.AddVideoTrack(static_cast<int32_t>(video->GetWidth()),
+                                   static_cast<int32_t>(video->GetHeight()),
+                                   static_cast<int32_t>(track->GetNumber()));
+    } else if (track->GetType() == mkvparser::Track::kAudio) {
+      const auto *audio = static_cast<const mkvparser::AudioTrack *>(track);
+      number = muxer.AddAudioTrack(
+          static_cast<int32_t>(audio->GetSamplingRate()),
+          static_cast<int32_t>(audio->GetChannels()),
+          static_cast<int32_t>(track->GetNumber()));
+    }
+    mkvmuxer::Track *copy = number ? muxer.GetTrackByNumber(number) : nullptr;
+    if (!copy) {
+      continue;
+    }
+    copy->set_codec_id(track->GetCodecId());
+    size_t private_size = 0;
+    const unsigned char *codec_private = track->GetCodecPrivate(private_size);
+    if (codec_private && private_size > 0) {
+      copy->SetCodecPrivate(codec_private, private_size);
+    }
+  }
+
+  std::vector<unsigned char> buffer;
+  long long bytes = 0;
+  long long frames = 0;
+  bool ok = true;
+  forEachFrame(segment.get(), [&](const mkvparser::Cluster *cluster,
+                                  const mkvparser::Block *block,
+                                  const mkvparser::Block::Frame &frame) {
+    const uint64_t number = static_cast<uint64_t>(block->GetTrackNumber());
+    if (!ok || !muxer.GetTrackByNumber(number)) {
+      return;
+    }
+    buffer.resize(static_cast<size_t>(frame.len));
+    ok = frame.Read(reader.get(), buffer.data()) == 0 &&
+         muxer.AddFrame(buffer.data(), buffer.size(), number,
+                        static_cast<uint64_t>(block->GetTime(cluster)),
+                        block->IsKey());
+    bytes += frame.len;
+    ++frames;
+  });
+  result.bytes = bytes;
+  result.frames = frames;
+  return ok && muxer.Finalize();
+}
+
+// Mux |total_bytes| of synthetic 30 fps video (a keyframe every 60 frames)
+// and 20 ms Opus packets to |writer|
+bool muxSynthetic(mkvmuxer::IMkvWriter *writer, long long total_bytes,
+                  Result &result) {
+  constexpr uint64_t kVideoFrameNs = 33333333;
+  constexpr uint64_t kAudioFrameNs = 20000000;
+  constexpr size_t kKeyframeSize = 256 * 1024;
+  constexpr size_t kDeltaSize = 64 * 1024;
+  constexpr size_t kAudioSize = 160;
+
+  mkvmuxer::Segment muxer;
+  if (!muxer.Init(writer)) {
+    return false;
+  }
+  muxer.set_mode(mkvmuxer::Segment::kFile);
+  const uint64_t video = muxer.AddVideoTrack(1920, 1080, 0);
+  const uint64_t audio = muxer.AddAudioTrack(48000, 2, 0);
+  if (!video || !audio) {
+    return false;
+  }
+  muxer.GetTrackByNumber(video)->set_codec_id("V_VP9");
+  muxer.GetTrackByNumber(audio)->set_codec_id("A_OPUS");
+  muxer.CuesTrack(video);
+
+  std::vector<uint8_t> payload(kKeyframeSize);
+  for (size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+  }
+
+  long long bytes = 0;
+  long long frames = 0;
+  uint64_t video_ns = 0;
+  uint64_t audio_ns = 0;
+  for (long long index = 0; bytes < total_bytes; ++index) {
+    const bool key = index % 60 == 0;
+    const size_t size = key ? kKeyframeSize : kDeltaSize;
+    if (!muxer.AddFrame(payload.data(), size, video, video_ns, key)) {
+      return false;
+    }
+    bytes += size;
+    ++frames;
+    video_ns += kVideoFrameNs;
+
+    for (; audio_ns < video_ns; audio_ns += kAudioFrameNs) {
+      if (!muxer.AddFrame(payload.data(), kAudioSize, audio, audio_ns, true)) {
+        return false;
+      }
+      bytes += kAudioSize;
+      ++frames;
+    }
+  }
+  result.bytes = bytes;
+  result.frames = frames;
+  return muxer.Finalize();
+}
+
+// --- Output ---
+
+std::string jsonString(const std::string &value) {
+  std::string out = "\"";
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+
+void printResult(const Result &result, bool last) {
+  const double per_second =
+      result.seconds > 0 ? result.iterations / result.seconds : 0;
+  std::printf("    {\"benchmark\": %s, \"file\": %s, \"ok\": %s, "
+              "\"iterations\": %lld, \"seconds\": %.6f",
+              jsonString(result.name).c_str(),
+              jsonString(result.file).c_str(), result.ok ? "true" : "false",
+              result.iterations, result.seconds);
+  if (result.bytes > 0) {
+    std::printf(", \"mb_per_s\": %.3f",
+                result.bytes * per_second / (1024.0 * 1024.0));
+  }
+  if (result.frames > 0) {
+    std::printf(", \"frames_per_s\": %.1f", result.frames * per_second);
+  }
+  if (result.ops > 0) {
+    std::printf(", \"ops_per_s\": %.1f", result.ops * per_second);
+  }
+  std::printf(", \"peak_heap_bytes\": %zu}%s\n", result.peak_heap,
+              last ? "" : ",");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  double min_time = 1.0;
+  long long mux_mb = 64;
+  long long synthetic_mb = 0;
+  std::string synthetic_path = "libwebm-bench-synthetic.webm";
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--min-time" && has_value) {
+      min_time = std::atof(argv[++i]);
+    } else if (arg == "--mux-mb" && has_value) {
+      mux_mb = std::atoll(argv[++i]);
+    } else if (arg == "--synthetic-mb" && has_value) {
+      synthetic_mb = std::atoll(argv[++i]);
+    } else if (arg == "--synthetic-path" && has_value) {
+      synthetic_path = argv[++i];
+    } else if (arg.compare(0, 2, "--") == 0) {
+      std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+      return 2;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.empty()) {
+    paths = {"test/sample.webm", "test/av1-opus.webm"};
+  }
+
+  std::vector<Result> results;
+
+  // Mux throughput into memory-less output, then the synthetic input
+  results.push_back(measure("mux", "synthetic", min_time, [&](Result &r) {
+    NullWriter writer;
+    return muxSynthetic(&writer, mux_mb * 1024 * 1024, r);
+  }));
+  if (synthetic_mb > 0) {
+    results.push_back(measure("mux_file", synthetic_path, 0, [&](Result &r) {
+      mkvmuxer::MkvWriter writer;
+      if (!writer.Open(synthetic_path.c_str())) {
+        return false;
+      }
+      const bool ok = muxSynthetic(&writer, synthetic_mb * 1024 * 1024, r);
+      writer.Close();
+      return ok;
+    }));
+    paths.push_back(synthetic_path);
+  }
+
+  int status = 0;
+  for (const std::string &path : paths) {
+    Input input;
+    if (!loadInput(path, input)) {
+      std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+      status = 1;
+      continue;
+    }
+
+    // A multi-GB input is only demuxed once per benchmark
+    const double file_time = input.inMemory() ? min_time : 0;
+    results.push_back(measure("parse_headers", path, min_time, [&](Result &r) {
+      return benchParseHeaders(input, r);
+    }));
+    results.push_back(measure("demux", path, file_time, [&](Result &r) {
+      return benchDemux(input, r);
+    }));
+    results.push_back(measure("seek", path, file_time, [&](Result &r) {
+      return benchSeek(input, r);
+    }));
+    results.push_back(measure("remux", path, file_time, [&](Result &r) {
+      return benchRemux(input, r);
+    }));
+  }
+
+  std::printf("{\n  \"build\": \"%s\",\n  \"results\": [\n",
+#ifdef __EMSCRIPTEN__
+              "wasm"
+#else
+              "native"
+#endif
+  );
+  for (size_t i = 0; i < results.size(); ++i) {
+    printResult(results[i], i + 1 == results.size());
+    if (!results[i].ok) {
+      status = 1;
+    }
+  }
+  std::printf("  ]\n}\n");
+  return status;
+}
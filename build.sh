@@ -45,7 +45,7 @@ if ! command -v emcc &> /dev/null; then
 fi
 
 # Clean previous build
-rm -rf build dist
+rm -rf build build-mt build-simd build-size dist
 mkdir -p build dist
 
 # Clone libwebm if not present
@@ -54,14 +54,47 @@ if [ ! -d "libwebm" ]; then
     git clone https://chromium.googlesource.com/webm/libwebm
 fi
 
+# --stats builds every module with the hot-path counters behind getStats()
+# --split also builds the parse-only and mux-only module of every variant
+STATS_OPTION=-DLIBWEBM_JS_STATS=OFF
+SPLIT_OPTION=-DLIBWEBM_JS_SPLIT=OFF
+for arg in "$@"; do
+    [ "$arg" = "--stats" ] && STATS_OPTION=-DLIBWEBM_JS_STATS=ON
+    [ "$arg" = "--split" ] && SPLIT_OPTION=-DLIBWEBM_JS_SPLIT=ON
+done
+
 # Configure CMake for Emscripten
 cd build
 
 echo "Configuring with CMake..."
 emcmake cmake .. \
-    -DCMAKE_BUILD_TYPE=Release
+    -DCMAKE_BUILD_TYPE=Release "$STATS_OPTION" "$SPLIT_OPTION"
 
 echo "Building with make..."
 emmake make -j$(nproc)
 
+# Optional variants: --threads (dist/libwebm-mt.*), --simd (dist/libwebm-simd.*),
+# --size (dist/libwebm-size.*)
+build_variant() {
+    local dir=$1
+    shift
+    mkdir -p "$dir"
+    (
+        cd "$dir"
+        echo "Configuring variant $dir..."
+        emcmake cmake .. -DCMAKE_BUILD_TYPE=Release "$STATS_OPTION" \
+            "$SPLIT_OPTION" "$@"
+        emmake make -j$(nproc)
+    )
+}
+
+cd ..
+for arg in "$@"; do
+    case "$arg" in
+        --threads) build_variant build-mt -DLIBWEBM_JS_THREADS=ON ;;
+        --simd) build_variant build-simd -DLIBWEBM_JS_SIMD=ON ;;
+        --size) build_variant build-size -DLIBWEBM_JS_SIZE=ON ;;
+    esac
+done
+
 echo "Build complete! Files are in the dist/ directory."
@@ -49,6 +49,14 @@ export enum WebMTrackType {
     AUDIO = 2
 }
 
+/**
+ * Per-frame flag bits in a WebMFrameBatch
+ */
+export enum WebMFrameFlags {
+    KEYFRAME = 1 << 0,
+    INVISIBLE = 1 << 1
+}
+
 /**
  * Track information structure
  */
@@ -66,6 +74,16 @@ export interface WebMVideoInfo {
     width: number;
     height: number;
     frameRate: number;
+    displayWidth: number;
+    displayHeight: number;
+    /** Matroska Colour values, -1 when not stored in the file */
+    colour: {
+        matrixCoefficients: number;
+        bitsPerChannel: number;
+        range: number;
+        transferCharacteristics: number;
+        primaries: number;
+    };
 }
 
 /**
@@ -74,7 +92,10 @@ export interface WebMVideoInfo {
 export interface WebMAudioInfo {
     samplingFrequency: number;
     channels: number;
+    /** 0 when not stored in the file */
     bitDepth: number;
+    codecDelayNs: number;
+    seekPreRollNs: number;
 }
 
 /**
@@ -84,12 +105,126 @@ export interface WebMFrameData {
     data: Uint8Array;
     timestampNs: number;
     isKeyframe: boolean;
+    /**
+     * Return the buffer behind data to the parser's frame pool (copied
+     * frames only). data must not be used afterwards.
+     */
+    release?(): void;
+}
+
+/**
+ * Frames read in one call, as a packed payload plus parallel arrays.
+ * Frame i is data.subarray(offsets[i], offsets[i] + sizes[i]).
+ * The views are reused by the next readFrames() call.
+ */
+export interface WebMFrameBatch {
+    count: number;
+    data: Uint8Array;
+    offsets: Uint32Array;
+    sizes: Uint32Array;
+    timestampsNs: Float64Array;
+    flags: Uint8Array;
+}
+
+/**
+ * Frame shaped as an EncodedVideoChunkInit or EncodedAudioChunkInit
+ */
+export interface WebMChunkInit {
+    type: 'key' | 'delta';
+    /** Microseconds */
+    timestamp: number;
+    data: Uint8Array;
+}
+
+/**
+ * Fields of a VideoDecoderConfig built from track info
+ */
+export interface WebMVideoDecoderConfig {
+    codec: string;
+    codedWidth: number;
+    codedHeight: number;
+    displayAspectWidth: number;
+    displayAspectHeight: number;
+    description?: Uint8Array;
+    colorSpace?: { matrix?: string; transfer?: string; primaries?: string; fullRange?: boolean };
+}
+
+/**
+ * Fields of an AudioDecoderConfig built from track info
+ */
+export interface WebMAudioDecoderConfig {
+    codec: string;
+    sampleRate: number;
+    numberOfChannels: number;
+    description?: Uint8Array;
+}
+
+/**
+ * The parts of EncodedVideoChunk and EncodedAudioChunk the muxer uses
+ */
+export interface WebMEncodedChunk {
+    type: 'key' | 'delta';
+    /** Microseconds */
+    timestamp: number;
+    byteLength: number;
+    copyTo(destination: Uint8Array): void;
 }
 
 /**
  * WebM Parser for reading WebM files
  */
 export interface WebMParser {
+    /**
+     * Get a view over a parser-owned input buffer to write the file into
+     * @param size Size of the input in bytes
+     * @returns View over WASM memory, valid until the memory grows
+     * @throws Error if headers were already parsed
+     */
+    getWriteBuffer(size: number): Uint8Array;
+
+    /**
+     * Append a chunk of a streamed file; headers and clusters are parsed as
+     * soon as their bytes arrive. Consumed clusters are released once every
+     * audio and video track has been read from
+     * @param chunk Next bytes of the file
+     * @throws Error if the data is corrupted or the parser is not streaming
+     */
+    appendData(chunk: Uint8Array): void;
+
+    /**
+     * Signal that no more chunks will be appended
+     * @throws Error if the stream is truncated before the headers
+     */
+    endOfStream(): void;
+
+    /**
+     * Whether the whole stream has been received
+     * @returns False while a streaming parser still expects data
+     */
+    isComplete(): boolean;
+
+    /**
+     * Only parse headers and Cues in parseHeaders(), loading clusters on
+     * demand as frames are read or sought
+     * @param enabled Whether clusters are loaded lazily
+     * @throws Error if headers were already parsed
+     */
+    setLazyLoading(enabled: boolean): void;
+
+    /**
+     * Skip damaged regions up to the next cluster instead of failing the
+     * parse; damage is reported by getParseErrors()
+     * @param enabled Whether to parse resiliently
+     * @throws Error if headers were already parsed
+     */
+    setResilient(enabled: boolean): void;
+
+    /**
+     * Problems met while parsing and reading
+     * @returns Byte offset and WebMErrorCode of each problem
+     */
+    getParseErrors(): WebMParseError[];
+
     /**
      * Parse the WebM file headers
      * @throws Error if parsing fails
@@ -134,9 +269,17 @@ export interface WebMParser {
      */
     getAudioInfo(trackNumber: number): WebMAudioInfo;
 
+    /**
+     * Get the CodecPrivate bytes of a track without copying them
+     * @param trackNumber Track number
+     * @returns View over parser memory, or null if the track has none
+     * @throws Error if track not found
+     */
+    getCodecPrivate(trackNumber: number): Uint8Array | null;
+
     /**
      * Read the next video frame from the WebM file
-     * @param trackId Track ID to read from
+     * @param trackId Track number to read from (falls back to the first video track)
      * @returns Frame data or null if no more frames
      * @throws Error if reading fails
      */
@@ -144,11 +287,242 @@ export interface WebMParser {
 
     /**
      * Read the next audio frame from the WebM file
-     * @param trackId Track ID to read from
+     * @param trackId Track number to read from (falls back to the first audio track)
      * @returns Frame data or null if no more frames
      * @throws Error if reading fails
      */
     readNextAudioFrame(trackId: number): WebMFrameData | null;
+
+    /**
+     * Read several frames of a track in a single call
+     * @param trackNumber Track number to read from
+     * @param maxFrames Maximum number of frames in the batch
+     * @returns Batch of frames, empty when no more frames are available.
+     * Frames that cannot be read are left out and reported by
+     * getParseErrors().
+     * @throws Error if the track is not found
+     */
+    readFrames(trackNumber: number, maxFrames: number): WebMFrameBatch;
+
+    /**
+     * Same as readFrames(), but a batch ends with the last frame of a
+     * cluster
+     * @param trackNumber Track number
+     * @param maxFrames Maximum number of frames to read
+     * @returns Batch of at most one cluster's frames, count 0 at the end
+     */
+    readClusterFrames(trackNumber: number, maxFrames: number): WebMFrameBatch;
+
+    /**
+     * WebCodecs decoder config for a track, with the CodecPrivate as
+     * description where the codec registration takes one
+     * @param trackNumber Track number
+     * @returns Config, or null when WebCodecs cannot decode the codec
+     * @throws Error if the track does not exist
+     */
+    getDecoderConfig(trackNumber: number): WebMVideoDecoderConfig | WebMAudioDecoderConfig | null;
+
+    /**
+     * Read the next frame as a chunk init for new EncodedVideoChunk() or
+     * new EncodedAudioChunk(); data is a view as in readNextVideoFrameView(),
+     * copied out for file- and source-backed parsers
+     * @param trackNumber Track number
+     * @returns Chunk init, or null at the end of the track
+     */
+    readNextChunk(trackNumber: number): WebMChunkInit | null;
+
+    /**
+     * Same as frames(), one chunk init per frame
+     * @returns Chunk inits whose data views the batch buffer, valid until
+     * the next batch is read
+     * @throws Error if the track is missing or not found
+     */
+    chunks(options: {
+        track: number;
+        batchSize?: number;
+        ready?: () => Promise<void> | void;
+        sliceMs?: number;
+    }): AsyncGenerator<WebMChunkInit, void, undefined>;
+
+    /**
+     * Iterate over a track's frames one cluster batch at a time, reading
+     * only when the consumer asks for more
+     * @param options.track Track number
+     * @param options.batchSize Maximum frames per batch, default 256
+     * @param options.ready Called before each read; a returned promise holds
+     * reading back until it resolves
+     * @param options.sliceMs Reading time before yielding to the event loop,
+     * default 8
+     * @returns Batches valid until the next iteration
+     */
+    frames(options: {
+        track: number;
+        batchSize?: number;
+        ready?: () => Promise<void> | void;
+        sliceMs?: number;
+    }): AsyncGenerator<WebMFrameBatch, void, undefined>;
+
+    /**
+     * Index every track in a single pass over the file, so reads and seeks
+     * on a track skip the other tracks' blocks
+     * @throws Error if headers are not parsed or the stream is incomplete
+     */
+    buildIndex(): void;
+
+    /**
+     * Build the same index as buildIndex() by scanning clusters directly
+     * from the input, on worker threads in the threaded build
+     * @param threadCount Number of threads, 0 for one per core; capped by
+     * the module's thread pool (LIBWEBM_JS_THREAD_POOL_SIZE, default 4)
+     * @throws Error if headers are not parsed
+     */
+    buildIndexParallel(threadCount?: number): void;
+
+    /**
+     * Serialize the frame index into a compact, versioned blob tied to
+     * this input by its size and a checksum
+     * @returns Index blob
+     * @throws Error if no index was built
+     */
+    exportIndex(): Uint8Array;
+
+    /**
+     * Install an index from exportIndex() instead of scanning the clusters
+     * @param blob Index blob
+     * @throws Error if the blob is damaged or was made for another file
+     */
+    importIndex(blob: Uint8Array | ArrayBuffer): void;
+
+    /**
+     * Number of frames indexed for a track
+     * @param trackNumber Track number
+     * @returns Frame count, 0 before buildIndex()
+     */
+    getIndexedFrameCount(trackNumber: number): number;
+
+    /**
+     * Move the reader of a track to the keyframe at or before a timestamp,
+     * using the Cues index when present
+     * @param timestampNs Target timestamp in nanoseconds
+     * @param trackNumber Track number whose reader is repositioned
+     * @throws Error if the track is not found or the seek fails
+     */
+    seek(timestampNs: number, trackNumber: number): void;
+
+    /**
+     * Read the next video frame without copying its payload
+     * @param trackId Track ID to read from
+     * @returns Frame whose data views the parser input buffer, or null if no
+     * more frames. The view is valid while the parser is alive and until the
+     * WASM memory grows. File- and source-backed parsers return a copy.
+     * @throws Error if the frame lies outside the input buffer
+     */
+    readNextVideoFrameView(trackId: number): WebMFrameData | null;
+
+    /**
+     * Read the next audio frame without copying its payload
+     * @param trackId Track ID to read from
+     * @returns Frame whose data views the parser input buffer, or null if no
+     * more frames. Same lifetime rules as readNextVideoFrameView.
+     * @throws Error if the frame lies outside the input buffer
+     */
+    readNextAudioFrameView(trackId: number): WebMFrameData | null;
+
+    /**
+     * Read the next keyframe of a video track without reading delta frames.
+     * Uses the frame index or Cues when available; has its own position,
+     * separate from readNextVideoFrame(). `data` is a view as in
+     * readNextVideoFrameView().
+     * @param trackId Video track number
+     * @returns Keyframe, or null when there are no more
+     */
+    readNextKeyframe(trackId: number): WebMFrameData | null;
+
+    /**
+     * Hot-path counters since creation or the last resetStats()
+     * @returns Counters, or null unless built with LIBWEBM_JS_STATS
+     */
+    getStats(): WebMStats | null;
+
+    /**
+     * Reset the counters returned by getStats()
+     */
+    resetStats(): void;
+
+    /**
+     * Start over on another file, reusing the memory this parser has
+     * already allocated. Views from the previous file become invalid.
+     * @param buffer New file, or omitted to fill it through
+     * getWriteBuffer() or appendData()
+     */
+    reset(buffer?: Uint8Array | ArrayBuffer | null): void;
+
+    /**
+     * Like reset(), reading the new file from a source as with
+     * createFromSource()
+     */
+    rebind(source: WebMSource, options?: { blockSize?: number; cacheBlocks?: number }): void;
+}
+
+/**
+ * Counters returned by getStats() in builds with LIBWEBM_JS_STATS
+ */
+export interface WebMStats {
+    /** Reads issued by libwebm on the input */
+    reads: number;
+    /** Bytes returned by those reads */
+    bytesRead: number;
+    /** Clusters loaded so far (parser only) */
+    clustersLoaded?: number;
+    /** Block entries walked by the frame cursors */
+    blocksVisited: number;
+    /** Frames handed to the caller */
+    framesReturned: number;
+    /** Frame copies and output buffers allocated */
+    allocations: number;
+    /** Bytes copied from JS into WASM memory */
+    bytesCopiedIn: number;
+    /** Bytes copied for JS out of the input or output buffers */
+    bytesCopiedOut: number;
+    /** Frames added to the muxer */
+    framesWritten: number;
+    /** Bytes written by the muxer */
+    bytesWritten: number;
+    /** Chunks allocated as the muxer output grew */
+    writerChunks: number;
+    /** Cumulative time per phase, in nanoseconds */
+    phases: {
+        parseNs: number;
+        indexNs: number;
+        seekNs: number;
+        readNs: number;
+        muxNs: number;
+        finalizeNs: number;
+    };
+}
+
+/**
+ * Problem reported by WebMParser.getParseErrors()
+ */
+export interface WebMParseError {
+    /** Byte offset of the damaged element in the input */
+    position: number;
+    /** WebMErrorCode value */
+    code: WebMErrorCode;
+}
+
+/**
+ * Options for WebMMuxer.remux()
+ */
+export interface WebMRemuxOptions {
+    /** Cut point; output starts at the video keyframe at or before it */
+    startNs?: number;
+    /** Frames at or after this timestamp are dropped */
+    endNs?: number;
+    /** Input track numbers to copy, default every audio and video track */
+    tracks?: number[];
+    /** Output timestamp of the cut point, default 0 */
+    offsetNs?: number;
 }
 
 /**
@@ -195,35 +569,243 @@ export interface WebMMuxer {
     writeAudioFrame(trackId: number, frameData: Uint8Array, timestampNs: number): void;
 
     /**
-     * Finalize the WebM file and get the data
-     * @returns Complete WebM file data
+     * Get a view over the muxer-owned staging buffer to encode a frame into
+     * @param size Frame size in bytes
+     * @returns View over WASM memory, detached if the memory grows
+     */
+    getFrameBuffer(size: number): Uint8Array;
+
+    /**
+     * Write the first `size` bytes of the staging buffer as a frame
+     * @param trackId Track ID to write to
+     * @param size Frame size in bytes
+     * @param timestampNs Frame timestamp in nanoseconds
+     * @param isKeyframe Whether this frame is a keyframe
+     * @throws Error if writing fails
+     */
+    commitFrame(trackId: number, size: number, timestampNs: number, isKeyframe: boolean): void;
+
+    /**
+     * Write a live (streamable) file with no Cues and append-only output.
+     * Must be called before the first frame is written.
+     * @param enabled Whether to use live mode
+     */
+    setLiveMode(enabled: boolean): void;
+
+    /**
+     * Start a new cluster once the current one spans this duration. Cluster
+     * and cue settings must be set before the first frame is written.
+     * @param durationNs Maximum cluster duration in nanoseconds, 0 for no limit
+     */
+    setMaxClusterDuration(durationNs: number): void;
+
+    /**
+     * Start a new cluster once the current one holds this many bytes
+     * @param sizeBytes Maximum cluster size in bytes, 0 for no limit
+     */
+    setMaxClusterSize(sizeBytes: number): void;
+
+    /**
+     * Write exact cluster durations, at the cost of buffering one frame
+     */
+    setAccurateClusterDuration(enabled: boolean): void;
+
+    /**
+     * Whether to write Cues (on by default outside live mode)
+     */
+    setOutputCues(enabled: boolean): void;
+
+    /**
+     * Only add cue points for this track (defaults to the first video track)
+     * @throws Error if the track does not exist
+     */
+    setCuesTrack(trackId: number): void;
+
+    /**
+     * Place Cues before the clusters. Unless they fit a setCuesReserve()
+     * space, finalize() rewrites the whole output: an O(output) copy with
+     * about twice the output size in memory at its peak
+     */
+    setCuesFirst(enabled: boolean): void;
+
+    /**
+     * Reserve space ahead of the clusters for the Cues and place them first.
+     * Cues that fit are written in place at finalize(), without copying the
+     * output; larger ones fall back to the setCuesFirst() rewrite. Allow
+     * about 12 to 20 bytes per cue point.
+     * @param bytes Reserved size, 0 for none or at least 2
+     * @throws Error after frames were written or in live mode
+     */
+    setCuesReserve(bytes: number): void;
+
+    /**
+     * Copy frames from a parser into this muxer without passing them
+     * through JS. Output tracks are created from the input tracks, so call
+     * this on a muxer with no tracks or frames yet.
+     * @param parser Parser with headers parsed (not a streaming parser)
+     * @param options Trim range, track selection and timestamp offset
+     * @returns Number of frames written
+     */
+    remux(parser: WebMParser, options?: WebMRemuxOptions): number;
+
+    /**
+     * Live mode only: return the output produced since the last call and
+     * release it from the muxer
+     * @returns Newly completed output bytes
+     * @throws Error if the muxer is not in live mode
+     */
+    drain(): Uint8Array;
+
+    /**
+     * Hot-path counters since creation or the last resetStats()
+     * @returns Counters, or null unless built with LIBWEBM_JS_STATS
+     */
+    getStats(): WebMStats | null;
+
+    /**
+     * Reset the counters returned by getStats()
+     */
+    resetStats(): void;
+
+    /**
+     * Start a new file with no tracks, reusing the output memory of the
+     * previous one
+     * @param options.live Write a live stream, as in the constructor
+     */
+    reset(options?: { live?: boolean }): void;
+
+    /**
+     * Add a track from a WebCodecs encoder's metadata.decoderConfig; the
+     * description becomes the CodecPrivate
+     * @param config Video or audio decoder config
+     * @returns Track ID
+     * @throws Error if the codec cannot be written to WebM
+     */
+    addTrackFromConfig(config: WebMVideoDecoderConfig | WebMAudioDecoderConfig): number;
+
+    /**
+     * Set the CodecPrivate of a track, before the first frame
+     * @param trackId Track ID
+     * @param data CodecPrivate bytes
+     */
+    setCodecPrivate(trackId: number, data: Uint8Array | ArrayBuffer): void;
+
+    /**
+     * Write an EncodedVideoChunk or EncodedAudioChunk, copied straight into
+     * the staging buffer by chunk.copyTo()
+     * @param trackId Track ID
+     * @param chunk Encoded chunk, timestamp in microseconds
+     */
+    writeChunk(trackId: number, chunk: WebMEncodedChunk): void;
+
+    /**
+     * Finalize the WebM file and get the data (in live mode, only the
+     * output not yet drained)
+     * @returns Complete WebM file data, copied into a new array
      * @throws Error if finalization fails
      */
     finalize(): Uint8Array;
 
     /**
      * Get the current WebM data (before finalization)
-     * @returns Current WebM file data
+     * @returns Current WebM file data, copied into a new array
      */
     getData(): Uint8Array;
 }
 
+/**
+ * Random-access input read synchronously by the parser
+ */
+export interface WebMSource {
+    /** Total size in bytes */
+    size: number;
+    /**
+     * Fill target with the bytes at position
+     * @returns Number of bytes written
+     */
+    readInto(position: number, target: Uint8Array): number;
+}
+
 /**
  * WebM Parser Constructor
  */
 export interface WebMParserConstructor {
     /**
-     * Create a parser from file path (Node.js only)
+     * Create a parser reading a file of the Emscripten filesystem on demand
+     * (e.g. mounted with NODEFS or WORKERFS)
      * @param filePath Path to WebM file
      */
     new(filePath: string): WebMParser;
 
+    /**
+     * Create an empty parser to be filled through getWriteBuffer()
+     */
+    new(): WebMParser;
+
     /**
      * Create a parser from buffer data
      * @param buffer WebM file data
      * @returns Parser instance
      */
     createFromBuffer(buffer: Uint8Array): WebMParser;
+
+    /**
+     * Create a parser reading on demand from a source, through a block cache.
+     * Frame views stay valid only until the next read.
+     * @param source Input to read from
+     * @param blockSize Cache block size in bytes, 0 for 1 MiB
+     * @param cacheBlocks Number of cached blocks, 0 for 16
+     * @returns Parser instance
+     */
+    createFromSource(source: WebMSource, blockSize: number, cacheBlocks: number): WebMParser;
+}
+
+/**
+ * Input of WebMProber.probe(): a whole file, or its first bytes
+ */
+export type WebMProbeInput = Uint8Array | {
+    /** Leading bytes of the file */
+    data: Uint8Array;
+    /** Total file size, if known */
+    size?: number;
+};
+
+/**
+ * Track described by WebMProber.probe()
+ */
+export interface WebMProbedTrack extends WebMTrackInfo {
+    video?: WebMVideoInfo;
+    audio?: WebMAudioInfo;
+    codecPrivate: Uint8Array | null;
+}
+
+/**
+ * Result of WebMProber.probe() for one input
+ */
+export interface WebMProbeResult {
+    /** WebMErrorCode value */
+    status: WebMErrorCode;
+    /** More leading bytes are needed to reach the end of the Tracks */
+    truncated: boolean;
+    /** Duration, -1 when not stored in the file */
+    durationNs: number;
+    /** Byte offset of the Cues in the file, -1 when unknown */
+    cuesPosition: number;
+    tracks: WebMProbedTrack[];
+}
+
+/**
+ * Batch metadata probe reading headers only
+ */
+export interface WebMProber {
+    /**
+     * Probe many inputs, concurrently in the threaded build
+     * @param inputs Files or leading byte ranges
+     * @param threadCount Workers to use, 0 for one per core; capped by the
+     * module's thread pool
+     * @returns One result per input
+     */
+    probe(inputs: WebMProbeInput[], threadCount: number): WebMProbeResult[];
 }
 
 /**
@@ -234,22 +816,152 @@ export interface WebMMuxerConstructor {
      * Create a new WebM muxer
      */
     new(): WebMMuxer;
+
+    /**
+     * Create a muxer whose output buffer is reserved up front
+     * @param expectedSize Estimated output size in bytes
+     */
+    new(expectedSize: number): WebMMuxer;
 }
 
 /**
- * LibWebM Module interface (generated by Emscripten)
+ * LibWebM Module interface (generated by Emscripten). A parser-only
+ * module has no WebMMuxer, a muxer-only module no WebMParser or WebMProber.
  */
 export interface LibWebMModule {
     WebMErrorCode: typeof WebMErrorCode;
     WebMTrackType: typeof WebMTrackType;
     WebMParser: WebMParserConstructor;
     WebMMuxer: WebMMuxerConstructor;
+    WebMProber: { new(): WebMProber };
+    /** Whether the module was built with worker thread support */
+    threadsEnabled(): boolean;
+    /** Whether the module was built with WebAssembly SIMD */
+    simdEnabled(): boolean;
+    /** Whether getStats() reports counters (LIBWEBM_JS_STATS build) */
+    statsEnabled(): boolean;
+}
+
+/**
+ * Frames of one track read by a worker pool, laid out like a
+ * WebMFrameBatch but in buffers of their own
+ */
+export interface WebMDemuxedTrack extends WebMFrameBatch {
+    trackNumber: number;
+}
+
+/**
+ * Result of WebMWorkerPool.demux()
+ */
+export interface WebMDemuxResult {
+    durationNs: number;
+    tracks: WebMTrackInfo[];
+    frames: WebMDemuxedTrack[];
+    /** Range of timestamps kept */
+    startNs: number;
+    endNs: number;
+}
+
+/**
+ * Input of a worker pool job. An ArrayBuffer, or the buffer of a view,
+ * is transferred to the worker and detached; a SharedArrayBuffer is shared.
+ */
+export type WebMPoolInput = ArrayBuffer | SharedArrayBuffer | Uint8Array;
+
+export interface WebMWorkerPoolOptions {
+    /** Number of workers, default one per core */
+    workers?: number;
+    /** URL of wrapper-pool-worker.js, when bundled under another path */
+    workerUrl?: string | URL;
+    /** Options for createLibWebM() in each worker */
+    moduleOptions?: { threads?: boolean; simd?: boolean; size?: boolean };
+}
+
+/**
+ * Workers running the WASM parser and muxer off the calling thread
+ */
+export interface WebMWorkerPool {
+    /** Number of workers */
+    readonly size: number;
+
+    /**
+     * Parse the headers of a file
+     * @param input File data
+     */
+    info(input: WebMPoolInput): Promise<{ durationNs: number; tracks: WebMTrackInfo[] }>;
+
+    /**
+     * Read every frame of a file in one worker
+     * @param input File data
+     * @param options.tracks Track numbers, default every audio and video track
+     * @param options.startNs Keep frames at or after this timestamp
+     * @param options.endNs Keep frames before this timestamp
+     */
+    demux(input: WebMPoolInput, options?: { tracks?: number[]; startNs?: number; endNs?: number }): Promise<WebMDemuxResult>;
+
+    /**
+     * Demux consecutive time ranges of a file in parallel; together the
+     * results hold every frame once. Non-shared input is copied once into
+     * a SharedArrayBuffer.
+     * @param options.ranges Number of ranges, default one per worker
+     * @returns One result per range, in time order
+     */
+    demuxRanges(input: WebMPoolInput, options?: { ranges?: number; tracks?: number[] }): Promise<WebMDemuxResult[]>;
+
+    /**
+     * Remux a file in a worker, as WebMMuxer.remux()
+     * @param options.cuesFirst Write Cues before the clusters
+     */
+    remux(input: WebMPoolInput, options?: WebMRemuxOptions & { cuesFirst?: boolean }): Promise<{ data: Uint8Array; frameCount: number }>;
+
+    /**
+     * Stop the workers, rejecting jobs not finished yet
+     */
+    terminate(): void;
+}
+
+export namespace WebMWorkerPool {
+    /**
+     * Start a pool and load libwebm in each worker
+     */
+    export function create(options?: WebMWorkerPoolOptions): Promise<WebMWorkerPool>;
+}
+
+/**
+ * Module variant and instantiation options for the LibWebM factory.
+ * Other properties are passed to the Emscripten module as-is.
+ */
+export interface LibWebMOptions {
+    /** Load the multi-threaded build (libwebm-mt) */
+    threads?: boolean;
+    /** Use the SIMD build when the runtime supports it, default true */
+    simd?: boolean;
+    /** Prefer the -Oz build (libwebm-size) */
+    size?: boolean;
+    /**
+     * Load a module with only the parser (WebMParser, WebMProber) or only
+     * the muxer; falls back to the full module when it was not built
+     */
+    parts?: 'parser' | 'muxer';
+    /**
+     * Emscripten factory of the module to use (the default export of e.g.
+     * dist/libwebm-parser.js), for bundles that import a variant
+     * statically; skips the variant lookup above
+     */
+    moduleFactory?: (options?: any) => Promise<LibWebMModule>;
+    /** Precompiled .wasm of the selected variant, e.g. a Cloudflare Workers import */
+    wasmModule?: WebAssembly.Module;
+    /** URL of the .wasm, compiled while it downloads and cached per URL */
+    wasmUrl?: string | URL;
+    /** Response carrying the .wasm, compiled while it downloads */
+    wasmResponse?: Response | Promise<Response>;
+    [option: string]: any;
 }
 
 /**
  * LibWebM factory function (generated by Emscripten)
  */
-export default function LibWebMFactory(options?: any): Promise<LibWebMModule>;
+export default function LibWebMFactory(options?: LibWebMOptions): Promise<LibWebMModule>;
 
 /**
  * Utility functions for common operations
@@ -294,6 +1006,39 @@ export namespace WebMUtils {
      * @returns Array of supported audio codec IDs
      */
     export function getSupportedAudioCodecs(): string[];
+
+    /**
+     * Backpressure for WebMParser.frames(): resolves once a WebCodecs
+     * decoder or encoder has fewer than maxQueueSize pending items
+     * @param codec VideoDecoder, AudioDecoder, VideoEncoder or AudioEncoder
+     * @param maxQueueSize Queue size to stay under
+     */
+    export function whenQueueBelow(codec: EventTarget, maxQueueSize: number): () => Promise<void> | undefined;
+}
+
+/**
+ * Sources for WebMParserConstructor.createFromSource()
+ */
+export namespace WebMSources {
+    /**
+     * Read from an open Node.js file descriptor
+     * @param fs The Node.js fs module
+     * @param fd File descriptor
+     */
+    export function fromFileDescriptor(fs: any, fd: number): WebMSource;
+
+    /**
+     * Read from a Blob or File (workers only, uses FileReaderSync)
+     * @param blob Input data
+     */
+    export function fromBlob(blob: Blob): WebMSource;
+
+    /**
+     * Read a remote file with HTTP range requests (workers only)
+     * @param url File URL
+     * @param size File size; fetched with a HEAD request when omitted
+     */
+    export function fromUrl(url: string, size?: number): WebMSource;
 }
 
 /**
@@ -307,21 +1052,56 @@ export class WebMFile {
      * Load WebM file from buffer
      * @param buffer WebM file data
      * @param module LibWebM module instance
+     * @param options Set `lazy` to load clusters only as they are read,
+     *                `resilient` to skip damaged regions, `index` to load
+     *                a blob from exportIndex() instead of scanning
      */
-    static async fromBuffer(buffer: Uint8Array, module: LibWebMModule): Promise<WebMFile> {
+    static async fromBuffer(buffer: Uint8Array, module: LibWebMModule, options: { lazy?: boolean; resilient?: boolean; index?: Uint8Array } = {}): Promise<WebMFile> {
         const file = new WebMFile();
         file.parser = module.WebMParser.createFromBuffer(buffer);
+        if (options.lazy) {
+            file.parser.setLazyLoading(true);
+        }
+        if (options.resilient) {
+            file.parser.setResilient(true);
+        }
+        await file.parser.parseHeaders();
+        if (options.index) {
+            file.parser.importIndex(options.index);
+        }
+        return file;
+    }
+
+    /**
+     * Load WebM file from a random-access source, read on demand
+     * @param source Input to read from
+     * @param module LibWebM module instance
+     * @param options Cache geometry, `lazy` to load clusters only as they are
+     *                read and `index` as in fromBuffer()
+     */
+    static async fromSource(source: WebMSource, module: LibWebMModule, options: { blockSize?: number; cacheBlocks?: number; lazy?: boolean; index?: Uint8Array } = {}): Promise<WebMFile> {
+        const file = new WebMFile();
+        file.parser = module.WebMParser.createFromSource(source, options.blockSize || 0, options.cacheBlocks || 0);
+        if (options.lazy) {
+            file.parser.setLazyLoading(true);
+        }
         await file.parser.parseHeaders();
+        if (options.index) {
+            file.parser.importIndex(options.index);
+        }
         return file;
     }
 
     /**
      * Create new WebM file for writing
      * @param module LibWebM module instance
+     * @param options.expectedSize Estimated output size in bytes
      */
-    static forWriting(module: LibWebMModule): WebMFile {
+    static forWriting(module: LibWebMModule, options: { expectedSize?: number } = {}): WebMFile {
         const file = new WebMFile();
-        file.muxer = new module.WebMMuxer();
+        file.muxer = options.expectedSize && options.expectedSize > 0
+            ? new module.WebMMuxer(options.expectedSize)
+            : new module.WebMMuxer();
         return file;
     }
 
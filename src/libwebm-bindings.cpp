@@ -28,16 +28,36 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
+#include <limits>
+#include <list>
+#include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <vector>
 
+#ifdef LIBWEBM_JS_THREADS
+#include <atomic>
+#include <thread>
+#endif
+
+#ifdef LIBWEBM_JS_STATS
+#include <chrono>
+#endif
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
 // Include libwebm headers
 #include "common/file_util.h"
+#include "common/webmids.h"
 #include "mkvmuxer/mkvmuxer.h"
 #include "mkvmuxer/mkvwriter.h"
 #include "mkvparser/mkvparser.h"
@@ -45,6 +65,11 @@
 
 using namespace emscripten;
 
+// Feature-split builds: LIBWEBM_JS_NO_MUXER leaves out the writer and
+// WebMMuxer (the libwebm-parser module), LIBWEBM_JS_NO_PARSER leaves out
+// the readers, WebMParser, WebMProber and WebMMuxer::remux (the
+// libwebm-muxer module). The full module defines neither.
+
 // Error codes matching Swift implementation
 enum class WebMErrorCode {
   SUCCESS = 0,
@@ -56,9 +81,42 @@ enum class WebMErrorCode {
   INVALID_ARGUMENT = 6
 };
 
+// Raise an error to the JS caller. Size builds (LIBWEBM_JS_SIZE) compile
+// without C++ exceptions and throw a JS Error directly instead.
+[[noreturn]] void throwError(const std::string &message) {
+#ifdef __cpp_exceptions
+  throw std::runtime_error(message);
+#else
+  emscripten::val::global("Error").new_(message).throw_();
+#endif
+}
+
+#ifdef LIBWEBM_JS_THREADS
+// Workers the module starts with (CMake LIBWEBM_JS_THREAD_POOL_SIZE)
+#ifndef LIBWEBM_JS_THREAD_POOL_SIZE
+#define LIBWEBM_JS_THREAD_POOL_SIZE 4
+#endif
+
+// Threads for |jobs| parallel jobs: |requested|, or one per core for 0,
+// counting the calling thread. Capped by the started workers, since a
+// thread beyond them only starts once the caller yields to the event
+// loop, which join() never does.
+size_t workerCount(uint32_t requested, size_t jobs) {
+  size_t workers = requested ? requested : std::thread::hardware_concurrency();
+  workers = std::min<size_t>(workers, LIBWEBM_JS_THREAD_POOL_SIZE + 1);
+  return std::max<size_t>(1, std::min(workers, jobs));
+}
+#endif
+
 // Track type enum
 enum class WebMTrackType { UNKNOWN = 0, VIDEO = 1, AUDIO = 2 };
 
+// Per-frame flags in a batch returned by WebMParser::readFrames
+enum WebMFrameFlags : uint8_t {
+  FRAME_FLAG_KEYFRAME = 1 << 0,
+  FRAME_FLAG_INVISIBLE = 1 << 1
+};
+
 // Track info structure
 struct WebMTrackInfo {
   uint32_t track_number;
@@ -67,18 +125,64 @@ struct WebMTrackInfo {
   std::string name;
 };
 
-// Video info structure
+// Video info structure. Colour fields are -1 when not stored in the file.
 struct WebMVideoInfo {
   uint32_t width;
   uint32_t height;
   double frame_rate;
+  uint32_t display_width;
+  uint32_t display_height;
+  int32_t matrix_coefficients;
+  int32_t bits_per_channel;
+  int32_t range;
+  int32_t transfer_characteristics;
+  int32_t primaries;
 };
 
-// Audio info structure
+// Audio info structure. bit_depth is 0 when not stored in the file.
 struct WebMAudioInfo {
   double sampling_frequency;
   uint32_t channels;
   uint32_t bit_depth;
+  double codec_delay_ns;
+  double seek_pre_roll_ns;
+};
+
+#ifndef LIBWEBM_JS_NO_PARSER
+// Free list of frame payload buffers. A WebMFrameData hands its buffer
+// back when JS deletes it, so a long demux keeps reusing a bounded set of
+// allocations instead of growing and fragmenting the heap frame by frame.
+class FramePool {
+public:
+  static constexpr size_t kMaxBuffers = 64;
+  // Larger buffers (rare huge keyframes) go back to the allocator
+  static constexpr size_t kMaxBufferSize = 4 * 1024 * 1024;
+
+  // A buffer of |size| bytes, recycled when one is large enough.
+  // |allocated| tells whether the heap had to be touched.
+  std::vector<uint8_t> Acquire(size_t size, bool &allocated) {
+    std::vector<uint8_t> buffer;
+    auto fit = std::find_if(
+        free_.rbegin(), free_.rend(),
+        [size](const std::vector<uint8_t> &b) { return b.capacity() >= size; });
+    if (fit != free_.rend()) {
+      buffer.swap(*fit);
+      free_.erase(std::next(fit).base());
+    }
+    allocated = buffer.capacity() < size;
+    buffer.resize(size);
+    return buffer;
+  }
+
+  void Release(std::vector<uint8_t> &&buffer) {
+    if (free_.size() < kMaxBuffers && buffer.capacity() <= kMaxBufferSize) {
+      buffer.clear();
+      free_.push_back(std::move(buffer));
+    }
+  }
+
+private:
+  std::vector<std::vector<uint8_t>> free_;
 };
 
 // Frame data structure
@@ -87,6 +191,14 @@ public:
   std::vector<uint8_t> data;
   uint64_t timestamp_ns;
   bool is_keyframe;
+  // Pool |data| returns to; shared so that frames may outlive their parser
+  std::shared_ptr<FramePool> pool;
+
+  ~WebMFrameData() {
+    if (pool) {
+      pool->Release(std::move(data));
+    }
+  }
 
   // Methods to access data for JavaScript
   emscripten::val getData() const {
@@ -97,17 +209,191 @@ public:
   uint64_t getTimestampNs() const { return timestamp_ns; }
   bool getIsKeyframe() const { return is_keyframe; }
 };
+#endif
+
+// --- EBML decoding ---
+// Shared by the parser's direct cluster scan and the muxer's finalize-time
+// patches, which read back element headers mkvmuxer has already written.
+
+// Decode an EBML size or track number at |pos|. Returns its length, or 0
+// when malformed or truncated. |unknown| is set for the reserved
+// all-ones value used by unknown-size elements.
+int readVint(const uint8_t *data, size_t size, size_t pos, uint64_t &value,
+             bool &unknown) {
+  if (pos >= size) {
+    return 0;
+  }
+  int len = 1;
+  uint8_t marker = 0x80;
+  while (len <= 8 && !(data[pos] & marker)) {
+    ++len;
+    marker >>= 1;
+  }
+  if (len > 8 || pos + len > size) {
+    return 0;
+  }
+
+  value = data[pos] & (marker - 1);
+  unknown = value == static_cast<uint64_t>(marker - 1);
+  for (int i = 1; i < len; ++i) {
+    value = (value << 8) | data[pos + i];
+    unknown = unknown && data[pos + i] == 0xFF;
+  }
+  return len;
+}
+
+// Decode an element ID at |pos|, keeping its marker bits as in webmids.h
+int readId(const uint8_t *data, size_t size, size_t pos, uint32_t &id) {
+  if (pos >= size || data[pos] < 0x10) {
+    return 0;
+  }
+  const int len = data[pos] >= 0x80 ? 1 : data[pos] >= 0x40 ? 2
+                                        : data[pos] >= 0x20 ? 3
+                                                            : 4;
+  if (pos + len > size) {
+    return 0;
+  }
+  id = 0;
+  for (int i = 0; i < len; ++i) {
+    id = (id << 8) | data[pos + i];
+  }
+  return len;
+}
+
+// Read the header of the element at |pos|, which must end by |end|
+bool readElement(const uint8_t *data, size_t end, size_t &pos, uint32_t &id,
+                 size_t &payload, size_t &next) {
+  const int id_len = readId(data, end, pos, id);
+  uint64_t size = 0;
+  bool unknown = false;
+  const int size_len =
+      id_len ? readVint(data, end, pos + id_len, size, unknown) : 0;
+  if (!size_len || unknown) {
+    return false;
+  }
+  payload = pos + id_len + size_len;
+  if (size > end - payload) {
+    return false;
+  }
+  next = payload + static_cast<size_t>(size);
+  return true;
+}
+
+uint64_t readUnsigned(const uint8_t *data, size_t begin, size_t end) {
+  uint64_t value = 0;
+  for (size_t i = begin; i < end; ++i) {
+    value = (value << 8) | data[i];
+  }
+  return value;
+}
+
+// --- Instrumentation ---
+// Built with LIBWEBM_JS_STATS, parsers and muxers count the work done on
+// their hot paths and getStats() reports it. Otherwise every WEBM_STAT()
+// statement compiles to nothing and getStats() returns null.
+#ifdef LIBWEBM_JS_STATS
+#define WEBM_STAT(...) __VA_ARGS__
+#else
+#define WEBM_STAT(...)
+#endif
+
+#ifdef LIBWEBM_JS_STATS
+struct WebMStats {
+  uint64_t reads = 0;      // IMkvReader::Read calls
+  uint64_t bytes_read = 0; // bytes returned by those calls
+  uint64_t blocks_visited = 0;
+  uint64_t frames_returned = 0;
+  uint64_t allocations = 0;      // frame copies and output buffers
+  uint64_t bytes_copied_in = 0;  // JS to WASM memory
+  uint64_t bytes_copied_out = 0; // copies handed to JS
+  uint64_t frames_written = 0;
+  uint64_t bytes_written = 0;
+  uint64_t writer_chunks = 0; // MemoryWriter growth steps
+
+  // Cumulative time per phase, in nanoseconds
+  uint64_t parse_ns = 0;
+  uint64_t index_ns = 0;
+  uint64_t seek_ns = 0;
+  uint64_t read_ns = 0;
+  uint64_t mux_ns = 0;
+  uint64_t finalize_ns = 0;
+
+  emscripten::val toVal() const {
+    emscripten::val stats = emscripten::val::object();
+    stats.set("reads", static_cast<double>(reads));
+    stats.set("bytesRead", static_cast<double>(bytes_read));
+    stats.set("blocksVisited", static_cast<double>(blocks_visited));
+    stats.set("framesReturned", static_cast<double>(frames_returned));
+    stats.set("allocations", static_cast<double>(allocations));
+    stats.set("bytesCopiedIn", static_cast<double>(bytes_copied_in));
+    stats.set("bytesCopiedOut", static_cast<double>(bytes_copied_out));
+    stats.set("framesWritten", static_cast<double>(frames_written));
+    stats.set("bytesWritten", static_cast<double>(bytes_written));
+    stats.set("writerChunks", static_cast<double>(writer_chunks));
+
+    emscripten::val phases = emscripten::val::object();
+    phases.set("parseNs", static_cast<double>(parse_ns));
+    phases.set("indexNs", static_cast<double>(index_ns));
+    phases.set("seekNs", static_cast<double>(seek_ns));
+    phases.set("readNs", static_cast<double>(read_ns));
+    phases.set("muxNs", static_cast<double>(mux_ns));
+    phases.set("finalizeNs", static_cast<double>(finalize_ns));
+    stats.set("phases", phases);
+    return stats;
+  }
+};
 
-// Custom reader for memory operations
-class MemoryReader : public mkvparser::MkvReader {
+// Adds the lifetime of the scope to a phase total
+class PhaseTimer {
+public:
+  explicit PhaseTimer(uint64_t &total)
+      : total_(total), start_(std::chrono::steady_clock::now()) {}
+  ~PhaseTimer() {
+    total_ += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_)
+            .count());
+  }
+
+private:
+  uint64_t &total_;
+  std::chrono::steady_clock::time_point start_;
+};
+#endif
+
+#ifndef LIBWEBM_JS_NO_PARSER
+// Source of the bytes a WebMParser reads. On top of the mkvparser reader
+// interface, frame views need a pointer to the payload of a frame.
+class InputReader : public mkvparser::IMkvReader {
+public:
+  virtual ~InputReader() {}
+
+  // Pointer to the bytes [pos, pos + len), or nullptr when they are not
+  // available. Only valid until the next call on the reader.
+  virtual const uint8_t *Span(long long pos, long len) = 0;
+
+  // Stream offset of the first byte still held by the reader
+  virtual long long Base() const { return 0; }
+
+  WEBM_STAT(void SetStats(WebMStats *stats) { stats_ = stats; })
+
+protected:
+  WEBM_STAT(WebMStats *stats_ = nullptr;)
+};
+
+// Custom reader for memory operations.
+// In streaming mode the buffer only holds the window [base, base + size) of
+// a stream that keeps growing, and the total length stays unknown until
+// SetComplete() is called.
+class MemoryReader : public InputReader {
 public:
   explicit MemoryReader(const std::vector<uint8_t> &data) : data_(data) {}
 
   int Read(long long pos, long len, unsigned char *buf) override {
-    if (pos < 0 || len < 0)
+    if (pos < base_ || len < 0)
       return -1;
 
-    size_t start = static_cast<size_t>(pos);
+    size_t start = static_cast<size_t>(pos - base_);
     size_t length = static_cast<size_t>(len);
 
     if (start >= data_.size())
@@ -117,385 +403,3318 @@ public:
     }
 
     std::copy(data_.begin() + start, data_.begin() + start + length, buf);
+    WEBM_STAT(if (stats_) {
+      ++stats_->reads;
+      stats_->bytes_read += length;
+    })
     return 0;
   }
 
   int Length(long long *total, long long *available) override {
-    *total = static_cast<long long>(data_.size());
-    *available = static_cast<long long>(data_.size());
+    *available = base_ + static_cast<long long>(data_.size());
+    *total = complete_ ? *available : -1;
     return 0;
   }
 
+  const uint8_t *Span(long long pos, long len) override {
+    if (pos < base_ || len < 0 ||
+        static_cast<size_t>(pos - base_) + static_cast<size_t>(len) >
+            data_.size())
+      return nullptr;
+    return data_.data() + (pos - base_);
+  }
+
+  // Stream offset of the first byte held in the buffer
+  long long Base() const override { return base_; }
+  void SetBase(long long base) { base_ = base; }
+
+  void SetComplete(bool complete) { complete_ = complete; }
+
 private:
   const std::vector<uint8_t> &data_;
+  long long base_ = 0;
+  bool complete_ = true;
+};
+
+// Reader over random-access storage outside the WASM heap (a file, a Blob,
+// an HTTP resource). Reads are served from an LRU cache of fixed-size
+// blocks so that mkvparser's many small element reads turn into a few
+// large fetches.
+class CachedReader : public InputReader {
+public:
+  static constexpr size_t kDefaultBlockSize = 1024 * 1024;
+  static constexpr size_t kDefaultCacheBlocks = 16;
+
+  CachedReader(long long size, size_t block_size, size_t cache_blocks)
+      : size_(size), block_size_(block_size ? block_size : kDefaultBlockSize),
+        cache_blocks_(cache_blocks ? cache_blocks : kDefaultCacheBlocks) {}
+
+  int Read(long long pos, long len, unsigned char *buf) override {
+    if (pos < 0 || len < 0 || pos + len > size_)
+      return -1;
+
+    WEBM_STAT(if (stats_) {
+      ++stats_->reads;
+      stats_->bytes_read += len;
+    })
+    while (len > 0) {
+      const Block *block = GetBlock(pos);
+      if (!block)
+        return -1;
+      const size_t offset = static_cast<size_t>(pos - block->start);
+      const long step = static_cast<long>(
+          std::min<size_t>(block->data.size() - offset, len));
+      std::memcpy(buf, block->data.data() + offset, step);
+      buf += step;
+      pos += step;
+      len -= step;
+    }
+    return 0;
+  }
+
+  int Length(long long *total, long long *available) override {
+    *total = *available = size_;
+    return 0;
+  }
+
+  const uint8_t *Span(long long pos, long len) override {
+    if (pos < 0 || len < 0 || pos + len > size_)
+      return nullptr;
+
+    const Block *block = GetBlock(pos);
+    if (!block)
+      return nullptr;
+    const size_t offset = static_cast<size_t>(pos - block->start);
+    if (offset + len <= block->data.size())
+      return block->data.data() + offset;
+
+    // The range straddles blocks: assemble it in the scratch buffer
+    scratch_.resize(len);
+    return Read(pos, len, scratch_.data()) == 0 ? scratch_.data() : nullptr;
+  }
+
+protected:
+  // Fill |buf| with the |len| bytes at |pos|; false on I/O error
+  virtual bool Fetch(long long pos, size_t len, uint8_t *buf) = 0;
+
+private:
+  struct Block {
+    long long start;
+    std::vector<uint8_t> data;
+  };
+
+  const Block *GetBlock(long long pos) {
+    const long long index = pos / static_cast<long long>(block_size_);
+    auto found = lookup_.find(index);
+    if (found != lookup_.end()) {
+      blocks_.splice(blocks_.begin(), blocks_, found->second);
+      return &blocks_.front();
+    }
+
+    // Recycle the least recently used block once the cache is full
+    if (blocks_.size() >= cache_blocks_) {
+      lookup_.erase(blocks_.back().start / static_cast<long long>(block_size_));
+      blocks_.splice(blocks_.begin(), blocks_, std::prev(blocks_.end()));
+    } else {
+      blocks_.emplace_front();
+    }
+
+    Block &block = blocks_.front();
+    block.start = index * static_cast<long long>(block_size_);
+    block.data.resize(static_cast<size_t>(
+        std::min<long long>(block_size_, size_ - block.start)));
+    if (!Fetch(block.start, block.data.size(), block.data.data())) {
+      blocks_.pop_front();
+      return nullptr;
+    }
+    lookup_[index] = blocks_.begin();
+    return &block;
+  }
+
+  const long long size_;
+  const size_t block_size_;
+  const size_t cache_blocks_;
+  std::list<Block> blocks_; // most recently used first
+  std::map<long long, std::list<Block>::iterator> lookup_;
+  std::vector<uint8_t> scratch_;
+};
+
+// Reader over a file of the Emscripten filesystem (NODEFS, WORKERFS, ...)
+class FileReader : public CachedReader {
+public:
+  static std::unique_ptr<FileReader> Open(const std::string &path,
+                                          size_t block_size,
+                                          size_t cache_blocks) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+      return nullptr;
+    if (fseeko(file, 0, SEEK_END) != 0) {
+      std::fclose(file);
+      return nullptr;
+    }
+    const long long size = static_cast<long long>(ftello(file));
+    return std::unique_ptr<FileReader>(
+        new FileReader(file, size, block_size, cache_blocks));
+  }
+
+  ~FileReader() override { std::fclose(file_); }
+
+protected:
+  bool Fetch(long long pos, size_t len, uint8_t *buf) override {
+    return fseeko(file_, static_cast<off_t>(pos), SEEK_SET) == 0 &&
+           std::fread(buf, 1, len, file_) == len;
+  }
+
+private:
+  FileReader(std::FILE *file, long long size, size_t block_size,
+             size_t cache_blocks)
+      : CachedReader(size, block_size, cache_blocks), file_(file) {}
+
+  std::FILE *file_;
 };
 
+// Reader over a JS object { size, readInto(position, target) } whose
+// readInto() synchronously fills the Uint8Array |target| and returns the
+// number of bytes written. |target| is a view into the block cache, so
+// sources such as fs.readSync() write straight into WASM memory.
+class SourceReader : public CachedReader {
+public:
+  SourceReader(emscripten::val source, size_t block_size, size_t cache_blocks)
+      : CachedReader(static_cast<long long>(source["size"].as<double>()),
+                     block_size, cache_blocks),
+        source_(std::move(source)) {}
+
+protected:
+  bool Fetch(long long pos, size_t len, uint8_t *buf) override {
+    const emscripten::val read = source_.call<emscripten::val>(
+        "readInto", static_cast<double>(pos),
+        emscripten::val(emscripten::typed_memory_view(len, buf)));
+    return read.isNumber() && read.as<double>() == static_cast<double>(len);
+  }
+
+private:
+  emscripten::val source_;
+};
+#endif
+
+#ifndef LIBWEBM_JS_NO_MUXER
+// --- EBML encoding ---
+// Only what the muxer's finalize-time patches need; mkvmuxer writes
+// everything else.
+
+int ebmlIdLength(uint32_t id) {
+  return id >= 0x1000000 ? 4 : id >= 0x10000 ? 3 : id >= 0x100 ? 2 : 1;
+}
+
+void appendEbmlId(std::vector<uint8_t> &out, uint32_t id) {
+  for (int i = ebmlIdLength(id) - 1; i >= 0; --i) {
+    out.push_back(static_cast<uint8_t>(id >> (8 * i)));
+  }
+}
+
+// Append |value| as an EBML size of |len| bytes, or of the shortest
+// length that holds it when |len| is 0
+void appendEbmlSize(std::vector<uint8_t> &out, uint64_t value, int len = 0) {
+  if (len == 0) {
+    len = 1;
+    while (len < 8 && value >= (uint64_t(1) << (7 * len)) - 1) {
+      ++len;
+    }
+  }
+  const uint64_t coded = value | (uint64_t(1) << (7 * len));
+  for (int i = len - 1; i >= 0; --i) {
+    out.push_back(static_cast<uint8_t>(coded >> (8 * i)));
+  }
+}
+
+void appendEbmlUnsigned(std::vector<uint8_t> &out, uint32_t id,
+                        uint64_t value) {
+  int len = 1;
+  while (len < 8 && (value >> (8 * len))) {
+    ++len;
+  }
+  appendEbmlId(out, id);
+  appendEbmlSize(out, len);
+  for (int i = len - 1; i >= 0; --i) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+// Append a Void element of exactly |size| bytes, which must be at least 2
+void appendEbmlVoid(std::vector<uint8_t> &out, size_t size) {
+  const int size_len = size <= 128 ? 1 : 8;
+  const size_t payload = size - 1 - size_len;
+  appendEbmlId(out, libwebm::kMkvVoid);
+  appendEbmlSize(out, payload, size_len);
+  out.resize(out.size() + payload, 0);
+}
+
 // Custom writer for memory operations
 class MemoryWriter : public mkvmuxer::IMkvWriter {
 public:
-  MemoryWriter() = default;
+  static constexpr size_t kInitialChunkSize = 64 * 1024;
+  static constexpr size_t kMaxChunkSize = 16 * 1024 * 1024;
+
+  // Output is kept in a list of chunks, so growing never moves bytes that
+  // were already written. Each new chunk is as large as all the previous
+  // ones together, up to kMaxChunkSize, so a short file stays small and a
+  // long one needs few chunks. When the final size is known up front, pass
+  // it as `expected_size` and the first chunk is reserved to hold it all.
+  explicit MemoryWriter(size_t expected_size = 0)
+      : next_chunk_size_(expected_size > 0 ? expected_size
+                                           : kInitialChunkSize) {}
 
   int64_t Position() const override { return position_; }
 
   int32_t Position(int64_t position) override {
     if (position < 0)
       return -1;
-    position_ = position;
-    if (static_cast<size_t>(position) > data_.size()) {
-      data_.resize(position);
+    if (!seekable_) {
+      return static_cast<size_t>(position) == position_ ? 0 : -1;
     }
+    const size_t new_position = static_cast<size_t>(position);
+    if (new_position > size_) {
+      // Seeking past the end leaves a hole that reads back as zeros
+      Reserve(new_position);
+      Fill(size_, new_position);
+      size_ = new_position;
+    }
+    position_ = new_position;
     return 0;
   }
 
-  bool Seekable() const override { return true; }
+  bool Seekable() const override { return seekable_; }
+
+  // A non-seekable writer only ever appends, which makes every written byte
+  // final and lets Drain() hand it out while muxing continues
+  void SetSeekable(bool seekable) { seekable_ = seekable; }
+
+  WEBM_STAT(void SetStats(WebMStats *stats) { stats_ = stats; })
 
   int32_t Write(const void *buf, uint32_t len) override {
     if (!buf || len == 0)
       return 0;
 
     const uint8_t *buffer = static_cast<const uint8_t *>(buf);
-    size_t end_pos = position_ + len;
-
-    if (end_pos > data_.size()) {
-      data_.resize(end_pos);
+    const size_t end_pos = position_ + len;
+    Reserve(end_pos);
+
+    size_t pos = position_;
+    while (pos < end_pos) {
+      Chunk &chunk = ChunkAt(pos);
+      const size_t offset = pos - chunk.start;
+      const size_t count = std::min(end_pos - pos, chunk.capacity - offset);
+      std::memcpy(chunk.bytes.get() + offset, buffer + (pos - position_),
+                  count);
+      pos += count;
     }
 
-    std::memcpy(data_.data() + position_, buffer, len);
     position_ = end_pos;
-
+    size_ = std::max(size_, end_pos);
+    WEBM_STAT(if (stats_) stats_->bytes_written += len;)
     return 0;
   }
 
+  // Where mkvmuxer started the top-level elements finalize() patches, as
+  // absolute positions; -1 until written
+  struct ElementLayout {
+    int64_t segment = -1;
+    int64_t seek_head = -1;
+    int64_t cues_reserve = -1;
+    int64_t info = -1;
+    int64_t cues = -1;
+  };
+
+  const ElementLayout &Layout() const { return layout_; }
+
+  // Write a Void of |size| bytes (0 for none, else at least 2) ahead of the
+  // segment Info, for the muxer to overwrite with the Cues at finalize.
+  // Nothing but the SeekHead's Info entry records an offset past it yet.
+  void ReserveCues(size_t size) { cues_reserve_size_ = size; }
+  size_t CuesReserveSize() const { return cues_reserve_size_; }
+
   void ElementStartNotify(uint64_t element_id, int64_t position) override {
-    // Optional: track element positions for debugging
+    switch (element_id) {
+    case libwebm::kMkvSegment:
+      if (layout_.segment < 0) {
+        layout_.segment = position;
+      }
+      break;
+    case libwebm::kMkvSeekHead:
+      layout_.seek_head = position;
+      break;
+    case libwebm::kMkvInfo:
+      if (layout_.info >= 0) {
+        break;
+      }
+      if (cues_reserve_size_ > 0) {
+        std::vector<uint8_t> reserve;
+        appendEbmlVoid(reserve, cues_reserve_size_);
+        Write(reserve.data(), static_cast<uint32_t>(reserve.size()));
+        layout_.cues_reserve = position;
+      }
+      layout_.info = Position();
+      break;
+    case libwebm::kMkvCues:
+      layout_.cues = position;
+      break;
+    default:
+      break;
+    }
   }
 
-  const std::vector<uint8_t> &GetData() const { return data_; }
+  size_t Size() const { return size_ - drained_; }
 
-  void Clear() {
-    data_.clear();
-    position_ = 0;
+  // Copy |len| bytes at offset |pos| of the undrained output into |buf|,
+  // straight from the chunks. Returns false past the end.
+  bool ReadAt(size_t pos, size_t len, uint8_t *buf) const {
+    pos += drained_;
+    if (pos > size_ || len > size_ - pos) {
+      return false;
+    }
+    const size_t end = pos + len;
+    while (pos < end) {
+      const Chunk &chunk = ChunkAt(pos);
+      const size_t offset = pos - chunk.start;
+      const size_t count = std::min(end - pos, chunk.capacity - offset);
+      std::memcpy(buf, chunk.bytes.get() + offset, count);
+      buf += count;
+      pos += count;
+    }
+    return true;
   }
 
-private:
-  std::vector<uint8_t> data_;
-  int64_t position_ = 0;
-};
+  // Copy the bytes written and not yet drained into a new JS Uint8Array,
+  // one chunk at a time, so the output is never merged into a second
+  // buffer inside WASM memory
+  emscripten::val CopyOut() const {
+    emscripten::val out =
+        emscripten::val::global("Uint8Array").new_(Size());
+    size_t pos = drained_;
+    while (pos < size_) {
+      const Chunk &chunk = ChunkAt(pos);
+      const size_t offset = pos - chunk.start;
+      const size_t count = std::min(size_ - pos, chunk.capacity - offset);
+      out.call<void>("set",
+                     emscripten::val(emscripten::typed_memory_view(
+                         count, chunk.bytes.get() + offset)),
+                     pos - drained_);
+      pos += count;
+    }
+    WEBM_STAT(if (stats_) stats_->bytes_copied_out += size_ - drained_;)
+    return out;
+  }
 
-// WebM Parser wrapper
-class WebMParser {
-private:
-  std::vector<uint8_t> buffer_;
-  bool headers_parsed_ = false;
-  uint64_t current_timestamp_ = 0;
-  uint32_t frame_count_ = 0;
+  // CopyOut(), then release every chunk that has been fully handed out
+  emscripten::val Drain() {
+    emscripten::val out = CopyOut();
+    drained_ = size_;
+
+    // Keep the chunk the next write lands in, drop the ones before it
+    auto keep = std::find_if(chunks_.begin(), chunks_.end(),
+                             [this](const Chunk &chunk) {
+                               return chunk.start + chunk.capacity > drained_;
+                             });
+    chunks_.erase(chunks_.begin(), keep);
+    return out;
+  }
 
-  // libwebm parser objects
-  mkvparser::MkvReader *reader_ = nullptr;
-  mkvparser::Segment *segment_ = nullptr;
-  const mkvparser::Tracks *tracks_ = nullptr;
+  // Replace |len| bytes already written at absolute position |pos|,
+  // leaving the write position where it was
+  void Overwrite(size_t pos, const uint8_t *buf, size_t len) {
+    const size_t position = position_;
+    position_ = pos;
+    Write(buf, static_cast<uint32_t>(len));
+    position_ = position;
+  }
 
-  // State for frame reading
-  const mkvparser::Cluster *current_cluster_ = nullptr;
-  const mkvparser::BlockEntry *current_block_entry_ = nullptr;
+  // Drop everything written from absolute position |size| on
+  void Truncate(size_t size) {
+    size_ = std::min(size_, size);
+    position_ = std::min(position_, size_);
+  }
 
-public:
-  WebMParser() = default; // Default constructor for createFromBuffer
+  // Exchange the output with |other|'s. Stats, the element layout and the
+  // Cues reserve stay with each writer.
+  void Swap(MemoryWriter &other) {
+    std::swap(chunks_, other.chunks_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(position_, other.position_);
+    std::swap(drained_, other.drained_);
+    std::swap(next_chunk_size_, other.next_chunk_size_);
+    std::swap(seekable_, other.seekable_);
+  }
 
-  WebMParser(const std::string &file_path) {
-    // For now, we'll implement file reading functionality
-    // In a web environment, you'd typically pass file data directly
-    throw std::runtime_error("File-based parsing not implemented for web "
-                             "environment. Use parseFromBuffer instead.");
+  void Clear() {
+    chunks_.clear();
+    capacity_ = 0;
+    size_ = 0;
+    position_ = 0;
+    drained_ = 0;
+    layout_ = ElementLayout();
+    cues_reserve_size_ = 0;
   }
 
-  ~WebMParser() {
-    if (segment_) {
-      delete segment_;
+  // Empty the writer but keep its chunks for the next output
+  void Rewind() {
+    capacity_ = 0;
+    for (Chunk &chunk : chunks_) {
+      chunk.start = capacity_;
+      capacity_ += chunk.capacity;
     }
-    if (reader_) {
-      delete reader_;
+    size_ = 0;
+    position_ = 0;
+    drained_ = 0;
+    seekable_ = true;
+    layout_ = ElementLayout();
+    cues_reserve_size_ = 0;
+  }
+
+private:
+  struct Chunk {
+    size_t start;
+    size_t capacity;
+    std::unique_ptr<uint8_t[]> bytes;
+  };
+
+  void Reserve(size_t size) {
+    if (size <= capacity_) {
+      return;
     }
+    const size_t chunk_size = std::max(next_chunk_size_, size - capacity_);
+    chunks_.push_back(
+        Chunk{capacity_, chunk_size, std::unique_ptr<uint8_t[]>(
+                                         new uint8_t[chunk_size])});
+    capacity_ += chunk_size;
+    // Chunks released by Drain() do not count towards the growth
+    const size_t held = capacity_ - chunks_.front().start;
+    next_chunk_size_ =
+        std::min(std::max(held, kInitialChunkSize), kMaxChunkSize);
+    WEBM_STAT(if (stats_) {
+      ++stats_->writer_chunks;
+      ++stats_->allocations;
+    })
   }
 
-  // Parse from buffer (more suitable for web environment)
-  static std::unique_ptr<WebMParser>
-  createFromBuffer(const emscripten::val &buffer_val) {
-    auto parser = std::make_unique<WebMParser>();
-    parser->buffer_ = emscripten::convertJSArrayToNumberVector<uint8_t>(buffer_val);
-    return parser;
+  Chunk &ChunkAt(size_t pos) {
+    return const_cast<Chunk &>(
+        static_cast<const MemoryWriter *>(this)->ChunkAt(pos));
   }
 
-  WebMErrorCode parseHeaders() {
-    if (buffer_.empty()) {
-      return WebMErrorCode::INVALID_ARGUMENT;
-    }
+  const Chunk &ChunkAt(size_t pos) const {
+    // Chunks are sorted by start; find the last one starting at or before pos
+    auto it = std::upper_bound(
+        chunks_.begin(), chunks_.end(), pos,
+        [](size_t value, const Chunk &chunk) { return value < chunk.start; });
+    return *(it - 1);
+  }
 
-    // Simple validation - check for WebM signature
-    if (buffer_.size() < 4) {
-      return WebMErrorCode::INVALID_FILE;
+  void Fill(size_t begin, size_t end) {
+    while (begin < end) {
+      Chunk &chunk = ChunkAt(begin);
+      const size_t offset = begin - chunk.start;
+      const size_t count = std::min(end - begin, chunk.capacity - offset);
+      std::memset(chunk.bytes.get() + offset, 0, count);
+      begin += count;
     }
+  }
 
-    try {
-      // Create reader and parse with libwebm
-      reader_ = new MemoryReader(buffer_);
-
-      long long pos = 0;
-      mkvparser::EBMLHeader ebmlHeader;
-      long long status = ebmlHeader.Parse(reader_, pos);
-      if (status < 0) {
-        return WebMErrorCode::CORRUPTED_DATA;
-      }
+  std::vector<Chunk> chunks_;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t position_ = 0;
+  // Absolute offset of the first byte not yet handed out by Drain()
+  size_t drained_ = 0;
+  size_t next_chunk_size_;
+  bool seekable_ = true;
+  ElementLayout layout_;
+  size_t cues_reserve_size_ = 0;
+  WEBM_STAT(WebMStats *stats_ = nullptr;)
+};
 
-      status = mkvparser::Segment::CreateInstance(reader_, pos, segment_);
-      if (status < 0) {
-        return WebMErrorCode::CORRUPTED_DATA;
-      }
+// Reader over the output of a MemoryWriter, chunk by chunk, so reading the
+// output back does not first merge it into one contiguous copy
+class WriterReader : public mkvparser::IMkvReader {
+public:
+  explicit WriterReader(const MemoryWriter &writer) : writer_(writer) {}
 
-      status = segment_->Load();
-      if (status < 0) {
-        return WebMErrorCode::CORRUPTED_DATA;
-      }
+  int Read(long long pos, long len, unsigned char *buf) override {
+    if (pos < 0 || len < 0 ||
+        !writer_.ReadAt(static_cast<size_t>(pos), static_cast<size_t>(len),
+                        buf))
+      return -1;
+    return 0;
+  }
 
-      tracks_ = segment_->GetTracks();
-      if (!tracks_) {
-        return WebMErrorCode::UNSUPPORTED_FORMAT;
-      }
+  int Length(long long *total, long long *available) override {
+    *total = *available = static_cast<long long>(writer_.Size());
+    return 0;
+  }
 
-      headers_parsed_ = true;
-      return WebMErrorCode::SUCCESS;
-    } catch (...) {
-      return WebMErrorCode::CORRUPTED_DATA;
+private:
+  const MemoryWriter &writer_;
+};
+#endif
+
+#ifndef LIBWEBM_JS_NO_PARSER
+// --- Serialized frame index ---
+// exportIndex() writes the per-track frame index as
+//   "WIDX" version:u8 source_size:varint source_crc:u32 track_count:varint
+//   per track: track_number:varint entry_count:varint, then per entry
+//     cluster_delta:varint block_index:varint pos_delta:zigzag size:varint
+//     frame_index:varint flags:u8 timestamp_delta:zigzag
+//   crc:u32 of everything before it
+// Deltas are taken from the previous entry of the same track. source_crc
+// covers the first and last kIndexFingerprintWindow bytes of the input,
+// enough to reject a blob made for another file without reading all of it.
+constexpr uint8_t kIndexBlobVersion = 1;
+constexpr size_t kIndexFingerprintWindow = 64 * 1024;
+
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
     }
   }
+  return ~crc;
+}
 
-  double getDuration() const {
-    if (!headers_parsed_ || !segment_) {
-      throw std::runtime_error("Headers not parsed");
-    }
+class IndexBlobWriter {
+public:
+  void Byte(uint8_t value) { data_.push_back(value); }
 
-    const mkvparser::SegmentInfo *const info = segment_->GetInfo();
-    if (!info) {
-      return 0.0;
+  void U32(uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      data_.push_back(static_cast<uint8_t>(value >> (8 * i)));
     }
+  }
 
-    const long long duration_ns = info->GetDuration();
-    if (duration_ns < 0) {
-      return 0.0;
+  void Varint(uint64_t value) {
+    while (value >= 0x80) {
+      data_.push_back(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
     }
+    data_.push_back(static_cast<uint8_t>(value));
+  }
 
-    // Convert from nanoseconds to seconds
-    return static_cast<double>(duration_ns) / 1000000000.0;
+  void Signed(int64_t value) {
+    Varint((static_cast<uint64_t>(value) << 1) ^
+           static_cast<uint64_t>(value >> 63));
   }
 
-  uint32_t getTrackCount() const {
-    if (!headers_parsed_ || !tracks_) {
-      throw std::runtime_error("Headers not parsed");
+  std::vector<uint8_t> &data() { return data_; }
+
+private:
+  std::vector<uint8_t> data_;
+};
+
+// Reads an IndexBlobWriter layout; every read fails once past the end
+class IndexBlobReader {
+public:
+  IndexBlobReader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  bool Byte(uint8_t &value) {
+    if (pos_ >= size_) {
+      return false;
+    }
+    value = data_[pos_++];
+    return true;
+  }
+
+  bool U32(uint32_t &value) {
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+      uint8_t byte;
+      if (!Byte(byte)) {
+        return false;
+      }
+      value |= static_cast<uint32_t>(byte) << (8 * i);
+    }
+    return true;
+  }
+
+  bool Varint(uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+      if (!Byte(byte)) {
+        return false;
+      }
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool Signed(int64_t &value) {
+    uint64_t encoded;
+    if (!Varint(encoded)) {
+      return false;
+    }
+    value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+    return true;
+  }
+
+  size_t position() const { return pos_; }
+
+private:
+  const uint8_t *data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+// WebM Parser wrapper
+class WebMParser {
+private:
+  std::vector<uint8_t> buffer_;
+  bool headers_parsed_ = false;
+  uint64_t current_timestamp_ = 0;
+  uint32_t frame_count_ = 0;
+
+  // Streaming state: input arrives through appendData() and clusters are
+  // loaded as soon as their bytes are available
+  bool streaming_ = false;
+  bool stream_complete_ = false;
+  bool clusters_loaded_ = false;
+
+  // Lazy mode: parseHeaders() stops before the first cluster and clusters
+  // are loaded on demand as cursors and seeks reach them
+  bool lazy_ = false;
+
+  WEBM_STAT(WebMStats stats_;)
+
+  // libwebm parser objects
+  InputReader *reader_ = nullptr;
+  // Set when the input comes from a file or JS source instead of buffer_
+  bool external_input_ = false;
+  mkvparser::Segment *segment_ = nullptr;
+  const mkvparser::Tracks *tracks_ = nullptr;
+
+  // State for frame reading. Each reader keeps its own position so that
+  // successive calls resume where the previous one stopped instead of
+  // rescanning the segment from the first cluster.
+  struct FrameCursor {
+    long track_number = -1; // resolved on first read
+    const mkvparser::Track *track = nullptr;
+    const mkvparser::Cluster *current_cluster = nullptr;
+    const mkvparser::BlockEntry *current_block_entry = nullptr;
+    int frame_index = 0;        // next laced frame of the current entry
+    bool entry_pending = false; // current entry not returned yet (after seek)
+    bool end_of_stream = false;
+
+    // Once the track is indexed the cursor walks the index instead
+    bool indexed = false;
+    size_t index_position = 0;
+  };
+  // By track number, whatever id the reader was called with
+  std::map<uint32_t, FrameCursor> cursors_;
+
+  // Location and metadata of one frame in the input
+  struct FrameRef {
+    long long pos = 0;
+    long len = 0;
+    long long timestamp_ns = 0;
+    bool is_keyframe = false;
+    bool is_invisible = false;
+  };
+
+  // Per-track frame index built in one pass by buildIndex(), so reads and
+  // seeks on a track never visit other tracks' blocks
+  struct FrameIndexEntry {
+    uint32_t cluster_index;
+    uint32_t block_index;
+    long long pos;
+    uint32_t size;
+    uint16_t frame_index; // position inside a laced block
+    uint8_t flags;
+    long long timestamp_ns;
+  };
+  std::map<long, std::vector<FrameIndexEntry>> track_indexes_;
+  // Storage of replaced or reset indexes, reused by the next one
+  std::vector<std::vector<FrameIndexEntry>> index_spares_;
+
+  // Position of readNextKeyframe() on one track, independent of the
+  // regular frame cursors. Walks the index, the Cues or the blocks,
+  // whichever is the cheapest available when the first keyframe is read.
+  struct KeyframeCursor {
+    enum Source { kUnresolved, kIndex, kCues, kBlocks };
+    Source source = kUnresolved;
+    const mkvparser::Track *track = nullptr;
+    size_t index_position = 0;
+    const mkvparser::CuePoint *cue_point = nullptr;
+    FrameCursor blocks;
+    long long last_timestamp_ns = -1;
+    // Keyframe found but not fully appended yet, returned by the next read
+    bool has_held = false;
+    FrameRef held;
+  };
+  std::map<uint32_t, KeyframeCursor> keyframe_cursors_;
+
+  // Resilient mode: damaged clusters are skipped instead of ending the
+  // parse, and every problem met while reading is recorded
+  bool resilient_ = false;
+  struct ParseError {
+    long long position; // byte offset in the input
+    WebMErrorCode code;
+  };
+  std::vector<ParseError> errors_;
+
+  // Storage reused by readFrames(): payloads packed back to back plus a
+  // struct-of-arrays table describing each frame
+  struct FrameBatch {
+    std::vector<uint8_t> payload;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> sizes;
+    std::vector<double> timestamps_ns;
+    std::vector<uint8_t> flags;
+  };
+  FrameBatch batch_;
+
+  // Payload buffers of the frames returned by readNextVideoFrame() and
+  // readNextAudioFrame()
+  std::shared_ptr<FramePool> frame_pool_ = std::make_shared<FramePool>();
+
+  // More input is expected before the segment can be read to its end
+  bool waitingForData() const { return streaming_ && !stream_complete_; }
+
+  // Entries of |track_number| in an index being built, taking the storage
+  // of an earlier index when some is left
+  std::vector<FrameIndexEntry> &
+  indexEntries(std::map<long, std::vector<FrameIndexEntry>> &indexes,
+               long track_number) {
+    const auto found = indexes.find(track_number);
+    if (found != indexes.end()) {
+      return found->second;
+    }
+    std::vector<FrameIndexEntry> &entries = indexes[track_number];
+    if (!index_spares_.empty()) {
+      entries.swap(index_spares_.back());
+      index_spares_.pop_back();
+    }
+    return entries;
+  }
+
+  void recycleIndexes(std::map<long, std::vector<FrameIndexEntry>> &indexes) {
+    for (auto &index : indexes) {
+      index.second.clear();
+      index_spares_.push_back(std::move(index.second));
+    }
+    indexes.clear();
+  }
+
+  // Make |indexes| the current index; the previous one becomes spare
+  void installIndexes(std::map<long, std::vector<FrameIndexEntry>> &indexes) {
+    track_indexes_.swap(indexes);
+    recycleIndexes(indexes);
+  }
+
+  void attachReader(InputReader *reader) {
+    reader_ = reader;
+    WEBM_STAT(reader_->SetStats(&stats_);)
+  }
+
+  long finishCursor(FrameCursor &cursor) {
+    cursor.current_cluster = nullptr;
+    cursor.current_block_entry = nullptr;
+    cursor.frame_index = 0;
+    cursor.entry_pending = false;
+    cursor.end_of_stream = true;
+    return 0;
+  }
+
+  // Load one more cluster in lazy mode. Returns false when the segment has
+  // no further cluster to offer.
+  bool loadNextCluster() {
+    if (!lazy_ || clusters_loaded_) {
+      return false;
+    }
+
+    const unsigned long count = segment_->GetCount();
+    while (segment_->GetCount() == count) {
+      long long pos = 0;
+      long len = 0;
+      const long status = segment_->LoadCluster(pos, len);
+      if (status != 0) {
+        if (status < 0) {
+          recordError(pos, WebMErrorCode::CORRUPTED_DATA);
+        }
+        clusters_loaded_ = true;
+        break;
+      }
+    }
+    return segment_->GetCount() > count;
+  }
+
+  // Move the cursor to the next block entry in segment order.
+  // Returns 1 when an entry is available, 0 once every cluster has been
+  // consumed, and E_BUFFER_NOT_FULL when the stream needs more data first.
+  long advanceCursor(FrameCursor &cursor) {
+    if (cursor.end_of_stream) {
+      return 0;
+    }
+    if (cursor.entry_pending) {
+      cursor.entry_pending = false;
+      cursor.frame_index = 0;
+      return 1;
+    }
+
+    for (;;) {
+      const mkvparser::Cluster *cluster = cursor.current_cluster;
+      if (!cluster) {
+        cluster = segment_->GetFirst();
+        if (!cluster || cluster->EOS()) {
+          if (loadNextCluster()) {
+            continue;
+          }
+          return waitingForData() ? mkvparser::E_BUFFER_NOT_FULL
+                                  : finishCursor(cursor);
+        }
+        cursor.current_cluster = cluster;
+        cursor.current_block_entry = nullptr;
+      }
+
+      const mkvparser::BlockEntry *block_entry = nullptr;
+      const long status =
+          cursor.current_block_entry
+              ? cluster->GetNext(cursor.current_block_entry, block_entry)
+              : cluster->GetFirst(block_entry);
+
+      if (status == mkvparser::E_BUFFER_NOT_FULL && waitingForData()) {
+        return status;
+      }
+      if (status < 0) {
+        recordError(cluster->m_element_start, WebMErrorCode::CORRUPTED_DATA);
+      }
+      if (status >= 0 && block_entry && !block_entry->EOS()) {
+        cursor.current_block_entry = block_entry;
+        cursor.frame_index = 0;
+        WEBM_STAT(++stats_.blocks_visited;)
+        return 1;
+      }
+
+      // Cluster exhausted or unreadable, move on to the next loaded one.
+      // Clusters preloaded by a Cues lookup have no index yet and are
+      // followed through Segment::GetNext directly.
+      const long index = cluster->GetIndex();
+      if (index >= 0 &&
+          index + 1 >= static_cast<long>(segment_->GetCount()) &&
+          !loadNextCluster()) {
+        return waitingForData() ? mkvparser::E_BUFFER_NOT_FULL
+                                : finishCursor(cursor);
+      }
+
+      cursor.current_cluster = segment_->GetNext(cluster);
+      cursor.current_block_entry = nullptr;
+      if (!cursor.current_cluster || cursor.current_cluster->EOS()) {
+        return finishCursor(cursor);
+      }
+    }
+  }
+
+  // Pick the track a reader refers to. Callers normally pass a track
+  // number; anything else falls back to the first track of the requested
+  // type, for callers passing a track index.
+  const mkvparser::Track *resolveTrack(uint32_t track_id,
+                                       long track_type) const {
+    const mkvparser::Track *track =
+        tracks_->GetTrackByNumber(static_cast<long>(track_id));
+    if (track && track->GetType() == track_type) {
+      return track;
+    }
+
+    const unsigned long count = tracks_->GetTracksCount();
+    for (unsigned long i = 0; i < count; ++i) {
+      track = tracks_->GetTrackByIndex(i);
+      if (track && track->GetType() == track_type) {
+        return track;
+      }
+    }
+    return nullptr;
+  }
+
+  // Spacing of the frames laced into one block: the track default duration
+  // when set, otherwise the block duration split evenly. 0 when unknown.
+  long long lacedFrameDuration(const mkvparser::BlockEntry *block_entry,
+                               const mkvparser::Track *track) const {
+    const int frame_count = block_entry->GetBlock()->GetFrameCount();
+    if (frame_count <= 1) {
+      return 0;
+    }
+
+    if (track && track->GetDefaultDuration() > 0) {
+      return static_cast<long long>(track->GetDefaultDuration());
+    }
+
+    if (block_entry->GetKind() == mkvparser::BlockEntry::kBlockGroup) {
+      const long long duration =
+          static_cast<const mkvparser::BlockGroup *>(block_entry)
+              ->GetDurationTimeCode();
+      if (duration > 0) {
+        return duration * segment_->GetInfo()->GetTimeCodeScale() /
+               frame_count;
+      }
+    }
+    return 0;
+  }
+
+  FrameRef blockFrameRef(const mkvparser::BlockEntry *block_entry,
+                         const mkvparser::Cluster *cluster, int frame_index,
+                         const mkvparser::Track *track) const {
+    const mkvparser::Block *const block = block_entry->GetBlock();
+    const mkvparser::Block::Frame &frame = block->GetFrame(frame_index);
+
+    FrameRef ref;
+    ref.pos = frame.pos;
+    ref.len = frame.len;
+    ref.timestamp_ns = block->GetTime(cluster);
+    if (frame_index > 0) {
+      ref.timestamp_ns += frame_index * lacedFrameDuration(block_entry, track);
+    }
+    ref.is_keyframe = block->IsKey();
+    ref.is_invisible = block->IsInvisible();
+    return ref;
+  }
+
+  // Move a cursor that was walking blocks onto the matching index entry
+  void syncCursorToIndex(FrameCursor &cursor,
+                         const std::vector<FrameIndexEntry> &entries) {
+    cursor.indexed = true;
+
+    if (cursor.end_of_stream) {
+      cursor.index_position = entries.size();
+      return;
+    }
+    if (!cursor.current_cluster) {
+      cursor.index_position = 0;
+      return;
+    }
+
+    // The cursor points at the next frame it would return
+    const std::tuple<uint32_t, uint32_t, uint32_t> key(
+        static_cast<uint32_t>(cursor.current_cluster->GetIndex()),
+        cursor.current_block_entry
+            ? static_cast<uint32_t>(cursor.current_block_entry->GetIndex())
+            : 0,
+        cursor.current_block_entry && !cursor.entry_pending
+            ? static_cast<uint32_t>(cursor.frame_index)
+            : 0);
+
+    const auto it = std::lower_bound(
+        entries.begin(), entries.end(), key,
+        [](const FrameIndexEntry &entry,
+           const std::tuple<uint32_t, uint32_t, uint32_t> &position) {
+          return std::make_tuple(entry.cluster_index, entry.block_index,
+                                 static_cast<uint32_t>(entry.frame_index)) <
+                 position;
+        });
+    cursor.index_position = static_cast<size_t>(it - entries.begin());
+  }
+
+  // Identifies the cluster of the frame last returned by |cursor|: the
+  // index position of the cluster on indexed tracks, its file offset
+  // otherwise. Only comparable between reads on the same cursor.
+  long long cursorCluster(const FrameCursor &cursor) const {
+    const auto index = track_indexes_.find(cursor.track_number);
+    if (index != track_indexes_.end()) {
+      return cursor.index_position > 0
+                 ? index->second[cursor.index_position - 1].cluster_index
+                 : -1;
+    }
+    return cursor.current_cluster ? cursor.current_cluster->m_element_start
+                                  : -1;
+  }
+
+  // Step |cursor| back over the frame it last returned, so the next read
+  // returns it again
+  void unreadFrame(FrameCursor &cursor) {
+    if (track_indexes_.count(cursor.track_number)) {
+      --cursor.index_position;
+    } else {
+      --cursor.frame_index;
+    }
+    WEBM_STAT(--stats_.frames_returned;)
+  }
+
+  // Whether the bytes of |frame| are present in the input
+  bool frameIsReadable(const FrameRef &frame) const {
+    long long total = 0;
+    long long available = 0;
+    if (external_input_) {
+      reader_->Length(&total, &available);
+      return frame.len > 0 && frame.pos >= 0 &&
+             frame.pos + frame.len <= available;
+    }
+    const long long offset = frame.pos - reader_->Base();
+    return frame.len > 0 && offset >= 0 &&
+           static_cast<unsigned long long>(offset + frame.len) <=
+               buffer_.size();
+  }
+
+  // The reader of a streaming parser
+  MemoryReader *streamReader() const {
+    return static_cast<MemoryReader *>(reader_);
+  }
+
+  // Advance the cursor attached to |track_id| to the next frame of its
+  // track, skipping (and recording) frames whose bytes are not in the
+  // input. Returns false at end of stream, or when a streaming parser is
+  // waiting for the next chunk.
+  bool nextFrame(uint32_t track_id, long track_type, FrameRef &frame) {
+    while (nextFrameRef(track_id, track_type, frame)) {
+      if (frameIsReadable(frame)) {
+        WEBM_STAT(++stats_.frames_returned;)
+        return true;
+      }
+      recordError(frame.pos, WebMErrorCode::CORRUPTED_DATA);
+    }
+    return false;
+  }
+
+  bool nextFrameRef(uint32_t track_id, long track_type, FrameRef &frame) {
+    // Cursors are keyed by the resolved track number, so a fallback id and
+    // the track number share one position (and seek() moves both)
+    const mkvparser::Track *const track = resolveTrack(track_id, track_type);
+    if (!track) {
+      return false;
+    }
+    FrameCursor &cursor = cursors_[static_cast<uint32_t>(track->GetNumber())];
+    if (cursor.track_number < 0) {
+      cursor.track_number = track->GetNumber();
+      cursor.track = track;
+    }
+
+    const auto index = track_indexes_.find(cursor.track_number);
+    if (index != track_indexes_.end()) {
+      const std::vector<FrameIndexEntry> &entries = index->second;
+      if (!cursor.indexed) {
+        syncCursorToIndex(cursor, entries);
+      }
+      if (cursor.index_position >= entries.size()) {
+        return false;
+      }
+
+      const FrameIndexEntry &entry = entries[cursor.index_position++];
+      frame.pos = entry.pos;
+      frame.len = static_cast<long>(entry.size);
+      frame.timestamp_ns = entry.timestamp_ns;
+      frame.is_keyframe = (entry.flags & FRAME_FLAG_KEYFRAME) != 0;
+      frame.is_invisible = (entry.flags & FRAME_FLAG_INVISIBLE) != 0;
+      return true;
+    }
+
+    // Hand out every laced frame of the current block before moving on
+    for (;;) {
+      if (cursor.current_block_entry && !cursor.entry_pending) {
+        const mkvparser::Block *const block =
+            cursor.current_block_entry->GetBlock();
+        if (block && block->GetTrackNumber() == cursor.track_number &&
+            cursor.frame_index < block->GetFrameCount()) {
+          frame = blockFrameRef(cursor.current_block_entry,
+                                cursor.current_cluster, cursor.frame_index,
+                                cursor.track);
+          ++cursor.frame_index;
+          return true;
+        }
+      }
+
+      if (advanceCursor(cursor) <= 0) {
+        return false;
+      }
+    }
+  }
+
+  bool cuesCoverTrack(const mkvparser::Track *track) const {
+    const mkvparser::Cues *const cues = segment_->GetCues();
+    if (!cues || streaming_) {
+      return false;
+    }
+    while (!cues->DoneParsing()) {
+      cues->LoadCuePoint();
+    }
+    for (const mkvparser::CuePoint *cue_point = cues->GetFirst(); cue_point;
+         cue_point = cues->GetNext(cue_point)) {
+      if (cue_point->Find(track)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Find the next keyframe of the video track |track_id| whose bytes are
+  // in the input. A streaming parser holds a keyframe that is only partly
+  // appended and returns false until the rest arrives; otherwise missing
+  // keyframes are skipped and recorded, like in nextFrame().
+  bool nextKeyframe(uint32_t track_id, FrameRef &frame) {
+    // Keyed by the resolved track number like cursors_, so a fallback id
+    // and the track number share one keyframe position
+    const mkvparser::Track *const track =
+        resolveTrack(track_id, mkvparser::Track::kVideo);
+    if (!track) {
+      return false;
+    }
+    KeyframeCursor &cursor =
+        keyframe_cursors_[static_cast<uint32_t>(track->GetNumber())];
+    cursor.track = track;
+    for (;;) {
+      if (cursor.has_held) {
+        frame = cursor.held;
+        cursor.has_held = false;
+      } else if (!nextKeyframeRef(cursor, frame)) {
+        return false;
+      }
+      if (frameIsReadable(frame)) {
+        return true;
+      }
+      if (waitingForData() && frame.pos >= reader_->Base()) {
+        cursor.held = frame;
+        cursor.has_held = true;
+        return false;
+      }
+      recordError(frame.pos, WebMErrorCode::CORRUPTED_DATA);
+    }
+  }
+
+  // Locate the next keyframe of |cursor|'s track. Only block headers are
+  // inspected on the way; the payload is left untouched.
+  bool nextKeyframeRef(KeyframeCursor &cursor, FrameRef &frame) {
+    if (cursor.source == KeyframeCursor::kUnresolved) {
+      if (track_indexes_.count(cursor.track->GetNumber())) {
+        cursor.source = KeyframeCursor::kIndex;
+      } else if (cuesCoverTrack(cursor.track)) {
+        cursor.source = KeyframeCursor::kCues;
+      } else {
+        cursor.source = KeyframeCursor::kBlocks;
+      }
+    }
+
+    const long track_number = cursor.track->GetNumber();
+    switch (cursor.source) {
+    case KeyframeCursor::kIndex: {
+      const std::vector<FrameIndexEntry> &entries =
+          track_indexes_[track_number];
+      while (cursor.index_position < entries.size()) {
+        const FrameIndexEntry &entry = entries[cursor.index_position++];
+        if ((entry.flags & FRAME_FLAG_KEYFRAME) && entry.frame_index == 0) {
+          frame.pos = entry.pos;
+          frame.len = static_cast<long>(entry.size);
+          frame.timestamp_ns = entry.timestamp_ns;
+          frame.is_keyframe = true;
+          frame.is_invisible = (entry.flags & FRAME_FLAG_INVISIBLE) != 0;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    case KeyframeCursor::kCues: {
+      // Cue points jump straight to the keyframes' clusters, which lazy
+      // parsers load on demand
+      const mkvparser::Cues *const cues = segment_->GetCues();
+      for (;;) {
+        cursor.cue_point = cursor.cue_point ? cues->GetNext(cursor.cue_point)
+                                            : cues->GetFirst();
+        if (!cursor.cue_point) {
+          return false;
+        }
+
+        const mkvparser::CuePoint::TrackPosition *const track_position =
+            cursor.cue_point->Find(cursor.track);
+        if (!track_position) {
+          continue;
+        }
+        const mkvparser::BlockEntry *const block_entry =
+            cues->GetBlock(cursor.cue_point, track_position);
+        if (!block_entry || block_entry->EOS()) {
+          continue;
+        }
+        const mkvparser::Block *const block = block_entry->GetBlock();
+        if (block->GetTrackNumber() != track_number || !block->IsKey()) {
+          continue;
+        }
+
+        frame = blockFrameRef(block_entry, block_entry->GetCluster(), 0,
+                              cursor.track);
+        if (frame.timestamp_ns <= cursor.last_timestamp_ns) {
+          continue;
+        }
+        cursor.last_timestamp_ns = frame.timestamp_ns;
+        return true;
+      }
+    }
+
+    case KeyframeCursor::kBlocks:
+    case KeyframeCursor::kUnresolved:
+      break;
+    }
+
+    while (advanceCursor(cursor.blocks) > 0) {
+      const mkvparser::BlockEntry *const block_entry =
+          cursor.blocks.current_block_entry;
+      const mkvparser::Block *const block = block_entry->GetBlock();
+      if (block->GetTrackNumber() == track_number && block->IsKey()) {
+        frame = blockFrameRef(block_entry, cursor.blocks.current_cluster, 0,
+                              cursor.track);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // --- Direct cluster scanning for buildIndexParallel() ---
+  // mkvparser objects are not thread-safe, so parallel indexing reads the
+  // clusters straight from the input buffer instead. Only element headers
+  // and block headers are decoded.
+
+  struct ClusterRange {
+    size_t payload;
+    size_t end;
+  };
+
+  // Find the first occurrence of element ID |id| in [begin, end), or |end|.
+  // This is a plain byte search: callers must validate what they find.
+  // The SIMD build (-msimd128) compares 16 positions at a time against the
+  // ID's first two bytes and only checks the full ID on those candidates.
+  static size_t findElementId(const uint8_t *data, size_t begin, size_t end,
+                              uint32_t id) {
+    uint8_t bytes[4];
+    const size_t len = id >= (1u << 24) ? 4 : id >= (1u << 16) ? 3
+                                          : id >= (1u << 8)  ? 2
+                                                             : 1;
+    for (size_t i = 0; i < len; ++i) {
+      bytes[i] = static_cast<uint8_t>(id >> (8 * (len - 1 - i)));
+    }
+    if (end < begin + len) {
+      return end;
+    }
+    const size_t last = end - len; // last position an ID can start at
+
+    size_t pos = begin;
+#ifdef __wasm_simd128__
+    if (len > 1) {
+      const v128_t first = wasm_i8x16_splat(static_cast<int8_t>(bytes[0]));
+      const v128_t second = wasm_i8x16_splat(static_cast<int8_t>(bytes[1]));
+      // Each step reads data[pos, pos + 17)
+      for (; pos + 16 <= last; pos += 16) {
+        const v128_t matches = wasm_v128_and(
+            wasm_i8x16_eq(wasm_v128_load(data + pos), first),
+            wasm_i8x16_eq(wasm_v128_load(data + pos + 1), second));
+        uint32_t mask = wasm_i8x16_bitmask(matches);
+        while (mask) {
+          const size_t candidate = pos + __builtin_ctz(mask);
+          if (std::memcmp(data + candidate, bytes, len) == 0) {
+            return candidate;
+          }
+          mask &= mask - 1;
+        }
+      }
+    }
+#endif
+
+    while (pos <= last) {
+      const void *const hit = std::memchr(data + pos, bytes[0], last - pos + 1);
+      if (!hit) {
+        return end;
+      }
+      pos = static_cast<size_t>(static_cast<const uint8_t *>(hit) - data);
+      if (std::memcmp(data + pos, bytes, len) == 0) {
+        return pos;
+      }
+      ++pos;
+    }
+    return end;
+  }
+
+  // Locate every cluster by hopping over the top-level elements of the
+  // segment. An unknown-size cluster (live streams) runs up to the next
+  // Cluster ID; scanCluster() rejects the range if that was a false match.
+  bool findClusters(std::vector<ClusterRange> &clusters) const {
+    const size_t size = buffer_.size();
+    size_t end = size;
+    if (segment_->m_size >= 0 &&
+        static_cast<unsigned long long>(segment_->m_start + segment_->m_size) <
+            size) {
+      end = static_cast<size_t>(segment_->m_start + segment_->m_size);
+    }
+
+    const uint8_t *const data = buffer_.data();
+    size_t pos = static_cast<size_t>(segment_->m_start);
+    while (pos < end) {
+      uint32_t id = 0;
+      size_t payload = 0;
+      size_t next = 0;
+      if (!readElement(data, end, pos, id, payload, next)) {
+        const int id_len = readId(data, end, pos, id);
+        uint64_t size = 0;
+        bool unknown = false;
+        const int size_len =
+            id_len ? readVint(data, end, pos + id_len, size, unknown) : 0;
+        if (id != libwebm::kMkvCluster || !size_len || !unknown) {
+          return false;
+        }
+        payload = pos + id_len + size_len;
+        next = findElementId(data, payload, end, libwebm::kMkvCluster);
+        clusters.push_back(ClusterRange{payload, next});
+        pos = next;
+        continue;
+      }
+      if (id == libwebm::kMkvCluster) {
+        clusters.push_back(ClusterRange{payload, next});
+      }
+      pos = next;
+    }
+    return true;
+  }
+
+  // Index the frames of one block. Mirrors mkvparser::Block::Parse for
+  // the lacing modes and blockFrameRef() for the timestamps.
+  bool scanBlock(size_t begin, size_t end, uint32_t cluster_index,
+                 uint32_t block_index, long long cluster_timecode,
+                 long long scale, bool simple, bool group_key,
+                 long long duration,
+                 std::vector<std::pair<long, FrameIndexEntry>> &out) const {
+    const uint8_t *const data = buffer_.data();
+    uint64_t track_number = 0;
+    bool unknown = false;
+    const int track_len = readVint(data, end, begin, track_number, unknown);
+    size_t pos = begin + track_len;
+    if (!track_len || pos + 3 > end) {
+      return false;
+    }
+
+    const int16_t relative = static_cast<int16_t>((data[pos] << 8) |
+                                                  data[pos + 1]);
+    const uint8_t flags = data[pos + 2];
+    pos += 3;
+
+    const bool is_key = simple ? (flags & 0x80) != 0 : group_key;
+    const bool is_invisible = (flags & 0x08) != 0;
+    const int lacing = (flags >> 1) & 0x03;
+
+    std::vector<size_t> sizes;
+    if (lacing == 0) {
+      sizes.push_back(end - pos);
+    } else {
+      if (pos >= end) {
+        return false;
+      }
+      const size_t count = static_cast<size_t>(data[pos++]) + 1;
+      size_t used = 0;
+
+      if (lacing == 1) { // Xiph
+        for (size_t i = 0; i + 1 < count; ++i) {
+          size_t frame_size = 0;
+          uint8_t byte = 0;
+          do {
+            if (pos >= end) {
+              return false;
+            }
+            byte = data[pos++];
+            frame_size += byte;
+          } while (byte == 0xFF);
+          sizes.push_back(frame_size);
+          used += frame_size;
+        }
+      } else if (lacing == 3) { // EBML
+        uint64_t first = 0;
+        const int len = readVint(data, end, pos, first, unknown);
+        if (!len) {
+          return false;
+        }
+        pos += len;
+        long long frame_size = static_cast<long long>(first);
+        sizes.push_back(static_cast<size_t>(frame_size));
+        used += sizes.back();
+        for (size_t i = 1; i + 1 < count; ++i) {
+          uint64_t raw = 0;
+          const int delta_len = readVint(data, end, pos, raw, unknown);
+          if (!delta_len) {
+            return false;
+          }
+          pos += delta_len;
+          const long long bias = (1LL << (7 * delta_len - 1)) - 1;
+          frame_size += static_cast<long long>(raw) - bias;
+          if (frame_size < 0) {
+            return false;
+          }
+          sizes.push_back(static_cast<size_t>(frame_size));
+          used += sizes.back();
+        }
+      } else { // Fixed-size lacing
+        if ((end - pos) % count) {
+          return false;
+        }
+        sizes.assign(count - 1, (end - pos) / count);
+        used = (count - 1) * ((end - pos) / count);
+      }
+
+      if (pos + used > end) {
+        return false;
+      }
+      sizes.push_back(end - pos - used);
+    }
+
+    const long number = static_cast<long>(track_number);
+    const mkvparser::Track *const track = tracks_->GetTrackByNumber(number);
+    long long spacing = 0;
+    if (sizes.size() > 1) {
+      if (track && track->GetDefaultDuration() > 0) {
+        spacing = static_cast<long long>(track->GetDefaultDuration());
+      } else if (duration > 0) {
+        spacing = duration * scale / static_cast<long long>(sizes.size());
+      }
+    }
+
+    const long long timestamp_ns = (cluster_timecode + relative) * scale;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      FrameIndexEntry entry;
+      entry.cluster_index = cluster_index;
+      entry.block_index = block_index;
+      entry.pos = static_cast<long long>(pos);
+      entry.size = static_cast<uint32_t>(sizes[i]);
+      entry.frame_index = static_cast<uint16_t>(i);
+      entry.flags = (is_key ? FRAME_FLAG_KEYFRAME : 0) |
+                    (is_invisible ? FRAME_FLAG_INVISIBLE : 0);
+      entry.timestamp_ns = timestamp_ns + static_cast<long long>(i) * spacing;
+      out.emplace_back(number, entry);
+      pos += sizes[i];
+    }
+    return true;
+  }
+
+  // Index every block of one cluster. Safe to run concurrently: it only
+  // reads the input buffer and the parsed track headers. On failure the
+  // frames decoded so far stay in |out| and |error_pos| receives the
+  // offset of the element that could not be read.
+  bool scanCluster(const ClusterRange &cluster, uint32_t cluster_index,
+                   long long scale,
+                   std::vector<std::pair<long, FrameIndexEntry>> &out,
+                   size_t *error_pos = nullptr) const {
+    const uint8_t *const data = buffer_.data();
+    const auto fail = [error_pos](size_t at) {
+      if (error_pos) {
+        *error_pos = at;
+      }
+      return false;
+    };
+    long long timecode = 0;
+    uint32_t block_index = 0;
+
+    size_t pos = cluster.payload;
+    while (pos < cluster.end) {
+      uint32_t id = 0;
+      size_t payload = 0;
+      size_t next = 0;
+      if (!readElement(data, cluster.end, pos, id, payload, next)) {
+        return fail(pos);
+      }
+
+      if (id == libwebm::kMkvTimecode) {
+        timecode = static_cast<long long>(readUnsigned(data, payload, next));
+      } else if (id == libwebm::kMkvSimpleBlock) {
+        if (!scanBlock(payload, next, cluster_index, block_index++, timecode,
+                       scale, true, false, 0, out)) {
+          return fail(pos);
+        }
+      } else if (id == libwebm::kMkvBlockGroup) {
+        size_t block_begin = 0;
+        size_t block_end = 0;
+        long long duration = 0;
+        bool referenced = false;
+
+        size_t child = payload;
+        while (child < next) {
+          uint32_t child_id = 0;
+          size_t child_payload = 0;
+          size_t child_next = 0;
+          if (!readElement(data, next, child, child_id, child_payload,
+                           child_next)) {
+            return fail(child);
+          }
+          if (child_id == libwebm::kMkvBlock) {
+            block_begin = child_payload;
+            block_end = child_next;
+          } else if (child_id == libwebm::kMkvBlockDuration) {
+            duration = static_cast<long long>(
+                readUnsigned(data, child_payload, child_next));
+          } else if (child_id == libwebm::kMkvReferenceBlock) {
+            referenced = true;
+          }
+          child = child_next;
+        }
+
+        if (block_end > block_begin &&
+            !scanBlock(block_begin, block_end, cluster_index, block_index++,
+                       timecode, scale, false, !referenced, duration, out)) {
+          return fail(pos);
+        }
+      }
+      pos = next;
+    }
+    return true;
+  }
+
+  void recordError(long long position, WebMErrorCode code) {
+    errors_.push_back(ParseError{position, code});
+  }
+
+  static bool isTopLevelId(uint32_t id) {
+    return id == libwebm::kMkvCluster || id == libwebm::kMkvCues ||
+           id == libwebm::kMkvSeekHead || id == libwebm::kMkvInfo ||
+           id == libwebm::kMkvTracks || id == libwebm::kMkvTags ||
+           id == libwebm::kMkvChapters || id == libwebm::kMkvVoid;
+  }
+
+  // Resilient mode: index the whole segment with the cluster scanner,
+  // recording each damaged region and resuming at the next Cluster ID.
+  // Frames decoded before the damage in a cluster are kept.
+  void buildResilientIndex() {
+    const uint8_t *const data = buffer_.data();
+    const size_t size = buffer_.size();
+    size_t end = size;
+    if (segment_->m_size >= 0 &&
+        static_cast<unsigned long long>(segment_->m_start + segment_->m_size) <
+            size) {
+      end = static_cast<size_t>(segment_->m_start + segment_->m_size);
+    }
+    const long long scale =
+        static_cast<long long>(segment_->GetInfo()->GetTimeCodeScale());
+
+    std::map<long, std::vector<FrameIndexEntry>> indexes;
+    for (unsigned long i = 0; i < tracks_->GetTracksCount(); ++i) {
+      const mkvparser::Track *const track = tracks_->GetTrackByIndex(i);
+      if (track) {
+        indexEntries(indexes, track->GetNumber());
+      }
+    }
+
+    uint32_t cluster_index = 0;
+    std::vector<std::pair<long, FrameIndexEntry>> frames;
+    size_t pos = static_cast<size_t>(segment_->m_start);
+    while (pos < end) {
+      uint32_t id = 0;
+      size_t payload = 0;
+      size_t next = 0;
+      if (!readElement(data, end, pos, id, payload, next)) {
+        // Unknown-size clusters, and clusters whose size overruns the
+        // segment, run to the next Cluster ID
+        const int id_len = readId(data, end, pos, id);
+        uint64_t element_size = 0;
+        bool unknown = false;
+        const int size_len =
+            id_len ? readVint(data, end, pos + id_len, element_size, unknown)
+                   : 0;
+        if (id == libwebm::kMkvCluster && size_len) {
+          payload = pos + id_len + size_len;
+          next = findElementId(data, payload, end, libwebm::kMkvCluster);
+        } else {
+          id = 0;
+        }
+      }
+
+      if (!isTopLevelId(id)) {
+        recordError(static_cast<long long>(pos),
+                    WebMErrorCode::CORRUPTED_DATA);
+        pos = findElementId(data, pos + 1, end, libwebm::kMkvCluster);
+        continue;
+      }
+
+      if (id == libwebm::kMkvCluster) {
+        frames.clear();
+        size_t error_pos = 0;
+        const bool complete = scanCluster(ClusterRange{payload, next},
+                                          cluster_index++, scale, frames,
+                                          &error_pos);
+        for (const auto &frame : frames) {
+          indexEntries(indexes, frame.first).push_back(frame.second);
+        }
+        if (!complete) {
+          recordError(static_cast<long long>(error_pos),
+                      WebMErrorCode::CORRUPTED_DATA);
+          next = findElementId(data, error_pos + 1, end, libwebm::kMkvCluster);
+        }
+      }
+      pos = next;
+    }
+
+    installIndexes(indexes);
+  }
+
+public:
+  WebMParser() = default; // Default constructor for createFromBuffer
+
+  // Parse a file of the Emscripten filesystem (e.g. mounted with NODEFS or
+  // WORKERFS) without loading it into memory
+  WebMParser(const std::string &file_path) {
+    std::unique_ptr<FileReader> reader =
+        FileReader::Open(file_path, CachedReader::kDefaultBlockSize,
+                         CachedReader::kDefaultCacheBlocks);
+    if (!reader) {
+      throwError("Cannot open " + file_path);
+    }
+    attachReader(reader.release());
+    external_input_ = true;
+  }
+
+  ~WebMParser() {
+    if (segment_) {
+      delete segment_;
+    }
+    if (reader_) {
+      delete reader_;
+    }
+  }
+
+  // Get ready for another file, as if newly created, while keeping the
+  // memory already allocated: input buffer, index storage, frame batch and
+  // frame pool. Settings from setLazyLoading() and setResilient() and the
+  // stats are kept. |buffer| is the new input; pass null to fill it with
+  // getWriteBuffer() or to start streaming. Views returned for the previous
+  // file are invalidated.
+  void reset(const emscripten::val &buffer_val) {
+    clear();
+    if (!buffer_val.isUndefined() && !buffer_val.isNull()) {
+      getWriteBuffer(buffer_val["length"].as<size_t>())
+          .call<void>("set", buffer_val);
+    }
+  }
+
+  // Same as reset(), then read the new file from a JS source, as with
+  // createFromSource()
+  void rebind(emscripten::val source, size_t block_size,
+              size_t cache_blocks) {
+    if (resilient_) {
+      throwError("Resilient mode needs an in-memory input");
+    }
+    clear();
+    attachReader(new SourceReader(std::move(source), block_size, cache_blocks));
+    external_input_ = true;
+  }
+
+  // Parse from buffer (more suitable for web environment)
+  static std::unique_ptr<WebMParser>
+  createFromBuffer(const emscripten::val &buffer_val) {
+    auto parser = std::make_unique<WebMParser>();
+    const size_t length = buffer_val["length"].as<size_t>();
+
+    // Allocate once and fill the WASM heap with a single bulk copy instead
+    // of converting the array element by element across the JS boundary
+    parser->getWriteBuffer(length).call<void>("set", buffer_val);
+    return parser;
+  }
+
+  // Parse from a JS object { size, readInto(position, target) } that reads
+  // synchronously: a Node file descriptor, a Blob read with FileReaderSync
+  // in a worker, or HTTP range requests. |block_size| and |cache_blocks|
+  // size the read cache; 0 selects the defaults (16 blocks of 1 MiB).
+  static std::unique_ptr<WebMParser>
+  createFromSource(emscripten::val source, size_t block_size,
+                   size_t cache_blocks) {
+    auto parser = std::make_unique<WebMParser>();
+    parser->attachReader(
+        new SourceReader(std::move(source), block_size, cache_blocks));
+    parser->external_input_ = true;
+    return parser;
+  }
+
+  // Resize the parser-owned input buffer and return a view over it, so the
+  // caller can write the file bytes straight into WASM memory. Must be called
+  // before parseHeaders(); the view is invalidated if the WASM memory grows.
+  emscripten::val getWriteBuffer(size_t size) {
+    if (reader_) {
+      throwError("Input buffer is already in use by the parser");
+    }
+
+    buffer_.resize(size);
+    WEBM_STAT(stats_.bytes_copied_in += size;)
+    return emscripten::val(
+        emscripten::typed_memory_view(buffer_.size(), buffer_.data()));
+  }
+
+  // Streaming mode: feed the file chunk by chunk. Headers and clusters are
+  // parsed as soon as enough bytes have arrived, and frames become readable
+  // once their cluster is received. Readers return null while waiting for
+  // data; isComplete() tells that apart from the end of the stream.
+  WebMErrorCode appendData(const emscripten::val &chunk_val) {
+    if ((reader_ && !streaming_) || resilient_) {
+      throwError("Parser was not created for streaming");
+    }
+    if (stream_complete_) {
+      throwError("Stream has already ended");
+    }
+
+    if (!reader_) {
+      streaming_ = true;
+      MemoryReader *reader = new MemoryReader(buffer_);
+      reader->SetComplete(false);
+      attachReader(reader);
+    }
+
+    WEBM_STAT(PhaseTimer phase_timer(stats_.parse_ns);)
+    discardConsumedData();
+
+    const size_t length = chunk_val["length"].as<size_t>();
+    WEBM_STAT(stats_.bytes_copied_in += length;)
+    const size_t offset = buffer_.size();
+    buffer_.resize(offset + length);
+    emscripten::val(
+        emscripten::typed_memory_view(length, buffer_.data() + offset))
+        .call<void>("set", chunk_val);
+
+    return parseAvailableData();
+  }
+
+  // Mark the end of a streamed input so the last cluster can be closed
+  WebMErrorCode endOfStream() {
+    if (!streaming_) {
+      return WebMErrorCode::INVALID_ARGUMENT;
+    }
+
+    stream_complete_ = true;
+    streamReader()->SetComplete(true);
+
+    const WebMErrorCode status = parseAvailableData();
+    if (status == WebMErrorCode::SUCCESS && !headers_parsed_) {
+      return WebMErrorCode::INVALID_FILE;
+    }
+    return status;
+  }
+
+  // True once headers are parsed and no more input is expected
+  bool isComplete() const { return headers_parsed_ && !waitingForData(); }
+
+  WebMErrorCode parseHeaders() {
+    if (streaming_) {
+      // Headers are parsed by appendData() as the chunks arrive
+      return headers_parsed_ ? WebMErrorCode::SUCCESS
+                             : WebMErrorCode::INVALID_ARGUMENT;
+    }
+
+    WEBM_STAT(PhaseTimer phase_timer(stats_.parse_ns);)
+    if (!external_input_) {
+      if (buffer_.empty()) {
+        return WebMErrorCode::INVALID_ARGUMENT;
+      }
+
+      // Simple validation - check for WebM signature
+      if (buffer_.size() < 4) {
+        return WebMErrorCode::INVALID_FILE;
+      }
+    }
+
+#ifdef __cpp_exceptions
+    try {
+      return loadSegment();
+    } catch (...) {
+      return WebMErrorCode::CORRUPTED_DATA;
+    }
+#else
+    return loadSegment();
+#endif
+  }
+
+  // Parse only the EBML header, SeekHead, Info, Tracks and Cues in
+  // parseHeaders(), leaving clusters to be loaded as they are read.
+  void setLazyLoading(bool lazy) {
+    if (segment_ || (reader_ && !external_input_)) {
+      throwError("Lazy loading must be set before parsing");
+    }
+    lazy_ = lazy;
+  }
+
+  // Survive damaged files: parseHeaders() indexes every cluster it can
+  // decode, skipping corrupt regions up to the next Cluster ID, and reads
+  // come from that index. Damage is reported by getParseErrors(). Must be
+  // set before parsing; not available for streaming parsers.
+  void setResilient(bool resilient) {
+    if (external_input_) {
+      throwError("Resilient mode needs an in-memory input");
+    }
+    if (reader_) {
+      throwError("Resilient mode must be set before parsing");
+    }
+    resilient_ = resilient;
+  }
+
+  // Problems met so far, as {position, code} with |code| a WebMErrorCode
+  // value. Corrupt frames are never returned by the readers.
+  emscripten::val getParseErrors() const {
+    emscripten::val errors = emscripten::val::array();
+    for (size_t i = 0; i < errors_.size(); ++i) {
+      emscripten::val error = emscripten::val::object();
+      error.set("position", static_cast<double>(errors_[i].position));
+      error.set("code", static_cast<int>(errors_[i].code));
+      errors.set(i, error);
+    }
+    return errors;
+  }
+
+  double getDuration() const {
+    if (!headers_parsed_ || !segment_) {
+      throwError("Headers not parsed");
+    }
+
+    const mkvparser::SegmentInfo *const info = segment_->GetInfo();
+    if (!info) {
+      return 0.0;
+    }
+
+    const long long duration_ns = info->GetDuration();
+    if (duration_ns < 0) {
+      return 0.0;
+    }
+
+    // Convert from nanoseconds to seconds
+    return static_cast<double>(duration_ns) / 1000000000.0;
+  }
+
+  uint32_t getTrackCount() const {
+    if (!headers_parsed_ || !tracks_) {
+      throwError("Headers not parsed");
+    }
+
+    return static_cast<uint32_t>(tracks_->GetTracksCount());
+  }
+
+  WebMTrackInfo getTrackInfo(uint32_t track_index) const {
+    if (!headers_parsed_ || !tracks_) {
+      throwError("Headers not parsed");
+    }
+
+    const unsigned long count = tracks_->GetTracksCount();
+    if (track_index >= count) {
+      throwError("Track index out of range");
+    }
+
+    const mkvparser::Track *const track = tracks_->GetTrackByIndex(track_index);
+    if (!track) {
+      throwError("Track not found");
+    }
+    return describeTrack(track);
+  }
+
+  WebMVideoInfo getVideoInfo(uint32_t track_number) const {
+    return describeVideo(static_cast<const mkvparser::VideoTrack *>(
+        findTrack(track_number, mkvparser::Track::kVideo)));
+  }
+
+  WebMAudioInfo getAudioInfo(uint32_t track_number) const {
+    return describeAudio(static_cast<const mkvparser::AudioTrack *>(
+        findTrack(track_number, mkvparser::Track::kAudio)));
+  }
+
+  // Metadata of a parsed track, shared with WebMProber
+  static WebMTrackInfo describeTrack(const mkvparser::Track *track) {
+    WebMTrackInfo info;
+    info.track_number = static_cast<uint32_t>(track->GetNumber());
+
+    // Determine track type
+    const long long type = track->GetType();
+    if (type == 1) { // Video
+      info.track_type = static_cast<uint32_t>(WebMTrackType::VIDEO);
+    } else if (type == 2) { // Audio
+      info.track_type = static_cast<uint32_t>(WebMTrackType::AUDIO);
+    } else {
+      info.track_type = static_cast<uint32_t>(WebMTrackType::UNKNOWN);
+    }
+
+    info.codec_id = track->GetCodecId() ? track->GetCodecId() : "unknown";
+    info.name = track->GetNameAsUTF8() ? track->GetNameAsUTF8() : "";
+
+    return info;
+  }
+
+  static WebMVideoInfo describeVideo(const mkvparser::VideoTrack *video) {
+    const mkvparser::Track *const track = video;
+
+    WebMVideoInfo info;
+    info.width = static_cast<uint32_t>(video->GetWidth());
+    info.height = static_cast<uint32_t>(video->GetHeight());
+
+    // FrameRate is rarely written, the default duration usually is
+    info.frame_rate = video->GetFrameRate();
+    if (info.frame_rate <= 0.0 && track->GetDefaultDuration() > 0) {
+      info.frame_rate =
+          1000000000.0 / static_cast<double>(track->GetDefaultDuration());
+    }
+
+    const long long display_width = video->GetDisplayWidth();
+    const long long display_height = video->GetDisplayHeight();
+    info.display_width = static_cast<uint32_t>(
+        display_width > 0 ? display_width : video->GetWidth());
+    info.display_height = static_cast<uint32_t>(
+        display_height > 0 ? display_height : video->GetHeight());
+
+    const mkvparser::Colour *const colour = video->GetColour();
+    info.matrix_coefficients =
+        colourValue(colour ? colour->matrix_coefficients : -1);
+    info.bits_per_channel = colourValue(colour ? colour->bits_per_channel : -1);
+    info.range = colourValue(colour ? colour->range : -1);
+    info.transfer_characteristics =
+        colourValue(colour ? colour->transfer_characteristics : -1);
+    info.primaries = colourValue(colour ? colour->primaries : -1);
+    return info;
+  }
+
+  static WebMAudioInfo describeAudio(const mkvparser::AudioTrack *audio) {
+    const mkvparser::Track *const track = audio;
+
+    WebMAudioInfo info;
+    info.sampling_frequency = audio->GetSamplingRate();
+    info.channels = static_cast<uint32_t>(audio->GetChannels());
+    info.bit_depth = static_cast<uint32_t>(
+        audio->GetBitDepth() > 0 ? audio->GetBitDepth() : 0);
+    info.codec_delay_ns = static_cast<double>(track->GetCodecDelay());
+    info.seek_pre_roll_ns = static_cast<double>(track->GetSeekPreRoll());
+    return info;
+  }
+
+  // CodecPrivate of a track as a view over the parser's copy, or null when
+  // the track has none. Valid while the parser is alive and until the WASM
+  // memory grows.
+  emscripten::val getCodecPrivate(uint32_t track_number) const {
+    if (!headers_parsed_ || !tracks_) {
+      throwError("Headers not parsed");
+    }
+
+    const mkvparser::Track *const track =
+        tracks_->GetTrackByNumber(static_cast<long>(track_number));
+    if (!track) {
+      throwError("Track not found");
+    }
+
+    size_t size = 0;
+    const unsigned char *const data = track->GetCodecPrivate(size);
+    if (!data || size == 0) {
+      return emscripten::val::null();
+    }
+    return emscripten::val(emscripten::typed_memory_view(size, data));
+  }
+
+  std::unique_ptr<WebMFrameData> readNextVideoFrame(uint32_t track_id) {
+    if (!headers_parsed_ || !segment_) {
+      return nullptr;
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.read_ns);)
+
+    FrameRef frame;
+    if (!nextFrame(track_id, mkvparser::Track::kVideo, frame)) {
+      return nullptr;
+    }
+
+    return copyFrame(frame, frame.is_keyframe);
+  }
+
+  std::unique_ptr<WebMFrameData> readNextAudioFrame(uint32_t track_id) {
+    if (!headers_parsed_ || !segment_) {
+      return nullptr;
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.read_ns);)
+
+    FrameRef frame;
+    if (!nextFrame(track_id, mkvparser::Track::kAudio, frame)) {
+      return nullptr;
+    }
+
+    return copyFrame(frame, false); // Audio frames don't have keyframes
+  }
+
+  // Walk the whole segment once and record, for every track, where each
+  // frame lives. Subsequent reads and seeks on indexed tracks use the index
+  // directly and skip the blocks of other tracks.
+  WebMErrorCode buildIndex() {
+    if (!headers_parsed_ || !segment_ || waitingForData()) {
+      return WebMErrorCode::INVALID_ARGUMENT;
+    }
+    if (resilient_) {
+      return WebMErrorCode::SUCCESS; // Indexed by parseHeaders() already
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.index_ns);)
+
+    std::map<long, std::vector<FrameIndexEntry>> indexes;
+    // Track and entries of each track number, looked up once rather than
+    // for every block
+    struct IndexTarget {
+      const mkvparser::Track *track;
+      std::vector<FrameIndexEntry> *entries;
+    };
+    std::map<long, IndexTarget> targets;
+    FrameCursor cursor;
+    while (advanceCursor(cursor) > 0) {
+      const mkvparser::Block *const block =
+          cursor.current_block_entry->GetBlock();
+      if (!block) {
+        continue;
+      }
+
+      const long track_number = static_cast<long>(block->GetTrackNumber());
+      auto target = targets.find(track_number);
+      if (target == targets.end()) {
+        target = targets
+                     .emplace(track_number,
+                              IndexTarget{
+                                  tracks_->GetTrackByNumber(track_number),
+                                  &indexEntries(indexes, track_number)})
+                     .first;
+      }
+      const mkvparser::Track *const track = target->second.track;
+      std::vector<FrameIndexEntry> &entries = *target->second.entries;
+
+      const int frame_count = block->GetFrameCount();
+      for (int i = 0; i < frame_count; ++i) {
+        const FrameRef frame = blockFrameRef(
+            cursor.current_block_entry, cursor.current_cluster, i, track);
+
+        FrameIndexEntry entry;
+        entry.cluster_index =
+            static_cast<uint32_t>(cursor.current_cluster->GetIndex());
+        entry.block_index =
+            static_cast<uint32_t>(cursor.current_block_entry->GetIndex());
+        entry.pos = frame.pos;
+        entry.size = static_cast<uint32_t>(frame.len);
+        entry.frame_index = static_cast<uint16_t>(i);
+        entry.flags = (frame.is_keyframe ? FRAME_FLAG_KEYFRAME : 0) |
+                      (frame.is_invisible ? FRAME_FLAG_INVISIBLE : 0);
+        entry.timestamp_ns = frame.timestamp_ns;
+        entries.push_back(entry);
+      }
+    }
+
+    installIndexes(indexes);
+    return WebMErrorCode::SUCCESS;
+  }
+
+  // Same index as buildIndex(), built by scanning the clusters directly
+  // from the input buffer. In the threaded build (LIBWEBM_JS_THREADS) the
+  // clusters are spread over |thread_count| workers, 0 meaning one per
+  // core, within the worker pool (see workerCount()); otherwise they are
+  // scanned on the calling thread. Falls back to
+  // buildIndex() when the clusters cannot be located up front (streaming
+  // input, unknown-size clusters) or fail to scan.
+  WebMErrorCode buildIndexParallel(uint32_t thread_count) {
+    if (!headers_parsed_ || !segment_ || waitingForData()) {
+      return WebMErrorCode::INVALID_ARGUMENT;
+    }
+    if (resilient_) {
+      return WebMErrorCode::SUCCESS;
+    }
+
+    std::vector<ClusterRange> clusters;
+    if (streaming_ || external_input_ || !findClusters(clusters)) {
+      return buildIndex();
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.index_ns);)
+
+    const long long scale =
+        static_cast<long long>(segment_->GetInfo()->GetTimeCodeScale());
+    std::vector<std::vector<std::pair<long, FrameIndexEntry>>> results(
+        clusters.size());
+    std::vector<uint8_t> scanned(clusters.size(), 0);
+    const auto scan = [&](size_t i) {
+      scanned[i] = scanCluster(clusters[i], static_cast<uint32_t>(i), scale,
+                               results[i]);
+    };
+
+#ifdef LIBWEBM_JS_THREADS
+    const size_t workers = workerCount(thread_count, clusters.size());
+
+    // Workers pull cluster numbers from a shared counter; the calling
+    // thread takes part instead of idling in join()
+    std::atomic<size_t> next_cluster(0);
+    const auto work = [&]() {
+      for (size_t i = next_cluster++; i < clusters.size();
+           i = next_cluster++) {
+        scan(i);
+      }
+    };
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < workers; ++i) {
+      pool.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : pool) {
+      thread.join();
+    }
+#else
+    (void)thread_count;
+    for (size_t i = 0; i < clusters.size(); ++i) {
+      scan(i);
+    }
+#endif
+
+    if (std::find(scanned.begin(), scanned.end(), 0) != scanned.end()) {
+      return buildIndex();
+    }
+
+    // Results are per cluster, so concatenating them in cluster order
+    // keeps every track's entries sorted
+    std::map<long, std::vector<FrameIndexEntry>> indexes;
+    for (const auto &cluster_frames : results) {
+      for (const auto &frame : cluster_frames) {
+        indexEntries(indexes, frame.first).push_back(frame.second);
+      }
+    }
+    installIndexes(indexes);
+    return WebMErrorCode::SUCCESS;
+  }
+
+  // Number of frames recorded for a track by buildIndex()
+  uint32_t getIndexedFrameCount(uint32_t track_number) const {
+    const auto index = track_indexes_.find(static_cast<long>(track_number));
+    return index == track_indexes_.end()
+               ? 0
+               : static_cast<uint32_t>(index->second.size());
+  }
+
+  // Serialize the index of buildIndex() or buildIndexParallel() into a
+  // compact blob (layout above), to be stored with the file and given to
+  // importIndex() when it is opened again
+  emscripten::val exportIndex() {
+    if (!headers_parsed_ || track_indexes_.empty()) {
+      throwError("No frame index to export");
+    }
+
+    long long source_size = 0;
+    uint32_t source_crc = 0;
+    if (!sourceFingerprint(source_size, source_crc)) {
+      throwError("Cannot read the input to fingerprint it");
+    }
+
+    IndexBlobWriter blob;
+    for (const char magic : {'W', 'I', 'D', 'X'}) {
+      blob.Byte(static_cast<uint8_t>(magic));
+    }
+    blob.Byte(kIndexBlobVersion);
+    blob.Varint(static_cast<uint64_t>(source_size));
+    blob.U32(source_crc);
+    blob.Varint(track_indexes_.size());
+    for (const auto &index : track_indexes_) {
+      blob.Varint(static_cast<uint64_t>(index.first));
+      blob.Varint(index.second.size());
+      FrameIndexEntry previous = {};
+      for (const FrameIndexEntry &entry : index.second) {
+        blob.Varint(entry.cluster_index - previous.cluster_index);
+        blob.Varint(entry.block_index);
+        blob.Signed(entry.pos - previous.pos);
+        blob.Varint(entry.size);
+        blob.Varint(entry.frame_index);
+        blob.Byte(entry.flags);
+        blob.Signed(entry.timestamp_ns - previous.timestamp_ns);
+        previous = entry;
+      }
+    }
+    std::vector<uint8_t> &data = blob.data();
+    blob.U32(crc32(data.data(), data.size()));
+
+    emscripten::val bytes =
+        emscripten::val::global("Uint8Array").new_(data.size());
+    bytes.call<void>("set", emscripten::val(emscripten::typed_memory_view(
+                                data.size(), data.data())));
+    return bytes;
+  }
+
+  // Install an index from exportIndex() instead of scanning the clusters.
+  // With setLazyLoading(true), parseHeaders() then importIndex() opens a
+  // file without reading any cluster until frames are read. Fails with
+  // INVALID_FILE when the blob was made for another input and with
+  // CORRUPTED_DATA when it is damaged or of an unknown version.
+  WebMErrorCode importIndex(const emscripten::val &blob_val) {
+    if (!headers_parsed_ || !segment_ || streaming_) {
+      return WebMErrorCode::INVALID_ARGUMENT;
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.index_ns);)
+
+    std::vector<uint8_t> data(blob_val["length"].as<size_t>());
+    emscripten::val(emscripten::typed_memory_view(data.size(), data.data()))
+        .call<void>("set", blob_val);
+    if (data.size() < 9 || std::memcmp(data.data(), "WIDX", 4) != 0 ||
+        data[4] != kIndexBlobVersion) {
+      return WebMErrorCode::CORRUPTED_DATA;
+    }
+    IndexBlobReader trailer(data.data() + data.size() - 4, 4);
+    uint32_t blob_crc = 0;
+    trailer.U32(blob_crc);
+    if (crc32(data.data(), data.size() - 4) != blob_crc) {
+      return WebMErrorCode::CORRUPTED_DATA;
+    }
+
+    IndexBlobReader blob(data.data() + 5, data.size() - 9);
+    uint64_t source_size = 0;
+    uint32_t source_crc = 0;
+    uint64_t track_count = 0;
+    if (!blob.Varint(source_size) || !blob.U32(source_crc) ||
+        !blob.Varint(track_count)) {
+      return WebMErrorCode::CORRUPTED_DATA;
+    }
+    long long actual_size = 0;
+    uint32_t actual_crc = 0;
+    if (!sourceFingerprint(actual_size, actual_crc) ||
+        static_cast<uint64_t>(actual_size) != source_size ||
+        actual_crc != source_crc) {
+      return WebMErrorCode::INVALID_FILE;
+    }
+
+    std::map<long, std::vector<FrameIndexEntry>> indexes;
+    for (uint64_t t = 0; t < track_count; ++t) {
+      uint64_t track_number = 0;
+      uint64_t entry_count = 0;
+      if (!blob.Varint(track_number) || !blob.Varint(entry_count)) {
+        recycleIndexes(indexes);
+        return WebMErrorCode::CORRUPTED_DATA;
+      }
+      if (!tracks_->GetTrackByNumber(static_cast<long>(track_number))) {
+        recycleIndexes(indexes);
+        return WebMErrorCode::INVALID_FILE;
+      }
+
+      std::vector<FrameIndexEntry> &entries =
+          indexEntries(indexes, static_cast<long>(track_number));
+      FrameIndexEntry entry = {};
+      for (uint64_t i = 0; i < entry_count; ++i) {
+        uint64_t cluster_delta, block_index, size, frame_index;
+        int64_t pos_delta, timestamp_delta;
+        if (!blob.Varint(cluster_delta) || !blob.Varint(block_index) ||
+            !blob.Signed(pos_delta) || !blob.Varint(size) ||
+            !blob.Varint(frame_index) || !blob.Byte(entry.flags) ||
+            !blob.Signed(timestamp_delta)) {
+          recycleIndexes(indexes);
+          return WebMErrorCode::CORRUPTED_DATA;
+        }
+        entry.cluster_index += static_cast<uint32_t>(cluster_delta);
+        entry.block_index = static_cast<uint32_t>(block_index);
+        entry.pos += pos_delta;
+        entry.size = static_cast<uint32_t>(size);
+        entry.frame_index = static_cast<uint16_t>(frame_index);
+        entry.timestamp_ns += timestamp_delta;
+        entries.push_back(entry);
+      }
+    }
+
+    installIndexes(indexes);
+    return WebMErrorCode::SUCCESS;
+  }
+
+  // Read up to |max_frames| frames of a track in one call. Payloads are
+  // packed into one buffer and described by parallel offset, size,
+  // timestamp and flag arrays, all returned as views that stay valid until
+  // the next readFrames() call or WASM memory growth.
+  emscripten::val readFrames(uint32_t track_number, uint32_t max_frames) {
+    return readBatch(track_number, max_frames, false);
+  }
+
+  // Same as readFrames(), but the batch ends with the last frame of a
+  // cluster, so a caller can stop between clusters
+  emscripten::val readClusterFrames(uint32_t track_number,
+                                    uint32_t max_frames) {
+    return readBatch(track_number, max_frames, true);
+  }
+
+  // Position the reader of |track_number| on the keyframe at or before
+  // |timestamp_ns|, so the next read returns that frame. Uses the Cues index
+  // when present, and a binary search over cluster times otherwise.
+  WebMErrorCode seek(double timestamp_ns, uint32_t track_number) {
+    if (!headers_parsed_ || !segment_) {
+      return WebMErrorCode::INVALID_ARGUMENT;
+    }
+
+    const mkvparser::Track *const track =
+        tracks_->GetTrackByNumber(static_cast<long>(track_number));
+    if (!track) {
+      return WebMErrorCode::INVALID_ARGUMENT;
+    }
+
+    WEBM_STAT(PhaseTimer phase_timer(stats_.seek_ns);)
+    const long long time_ns =
+        timestamp_ns > 0 ? static_cast<long long>(timestamp_ns) : 0;
+
+    FrameCursor &cursor = cursors_[track_number];
+    cursor.track_number = track->GetNumber();
+    cursor.track = track;
+
+    const auto index = track_indexes_.find(cursor.track_number);
+    if (index != track_indexes_.end()) {
+      // Binary search the index, then step back to the keyframe
+      const std::vector<FrameIndexEntry> &entries = index->second;
+      size_t position = static_cast<size_t>(
+          std::upper_bound(entries.begin(), entries.end(), time_ns,
+                           [](long long time, const FrameIndexEntry &entry) {
+                             return time < entry.timestamp_ns;
+                           }) -
+          entries.begin());
+      while (position > 0 &&
+             !(entries[position - 1].flags & FRAME_FLAG_KEYFRAME)) {
+        --position;
+      }
+      cursor.indexed = true;
+      cursor.index_position = position > 0 ? position - 1 : 0;
+      return WebMErrorCode::SUCCESS;
+    }
+
+    const mkvparser::BlockEntry *block_entry = nullptr;
+    if (seekEntry(track, time_ns, block_entry) < 0) {
+      return WebMErrorCode::CORRUPTED_DATA;
+    }
+
+    cursor.indexed = false;
+    if (!block_entry || block_entry->EOS()) {
+      finishCursor(cursor);
+      return WebMErrorCode::SUCCESS;
+    }
+
+    const mkvparser::Cluster *const cluster = block_entry->GetCluster();
+    if (streaming_ && cluster->m_element_start < reader_->Base()) {
+      // Those bytes were already released by the streaming window
+      return WebMErrorCode::INVALID_ARGUMENT;
+    }
+
+    cursor.current_cluster = cluster;
+    cursor.current_block_entry = block_entry;
+    cursor.frame_index = 0;
+    cursor.entry_pending = true;
+    cursor.end_of_stream = false;
+    return WebMErrorCode::SUCCESS;
+  }
+
+  // Zero-copy variants of the readers. For a parser over a buffer the
+  // returned "data" is a view over it at the frame position, so no
+  // allocation or copy takes place. The view stays valid as long as the
+  // parser is alive and the WASM memory does not grow; copy it if it must
+  // outlive either. Streaming parsers may also compact their buffer on the
+  // next appendData(). File- and source-backed parsers have no buffer to
+  // view and return a copy instead (see frameData()).
+  emscripten::val readNextVideoFrameView(uint32_t track_id) {
+    if (!headers_parsed_ || !segment_) {
+      return emscripten::val::null();
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.read_ns);)
+
+    FrameRef frame;
+    if (!nextFrame(track_id, mkvparser::Track::kVideo, frame)) {
+      return emscripten::val::null();
+    }
+    return frameView(frame, frame.is_keyframe);
+  }
+
+  emscripten::val readNextAudioFrameView(uint32_t track_id) {
+    if (!headers_parsed_ || !segment_) {
+      return emscripten::val::null();
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.read_ns);)
+
+    FrameRef frame;
+    if (!nextFrame(track_id, mkvparser::Track::kAudio, frame)) {
+      return emscripten::val::null();
+    }
+    return frameView(frame, false);
+  }
+
+  // Next frame of a track shaped as an EncodedVideoChunkInit or
+  // EncodedAudioChunkInit: { type, timestamp (microseconds), data }, with
+  // data a view as in readNextVideoFrameView(), so a copy for file- and
+  // source-backed parsers. WebCodecs copies it when the chunk is
+  // constructed, so it can go straight to the constructor.
+  emscripten::val readNextChunk(uint32_t track_id) {
+    if (!headers_parsed_ || !segment_) {
+      return emscripten::val::null();
+    }
+    const mkvparser::Track *const track =
+        tracks_->GetTrackByNumber(static_cast<long>(track_id));
+    if (!track) {
+      return emscripten::val::null();
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.read_ns);)
+
+    FrameRef frame;
+    if (!nextFrame(track_id, track->GetType(), frame)) {
+      return emscripten::val::null();
+    }
+    // Every audio frame decodes on its own
+    const bool is_key =
+        frame.is_keyframe || track->GetType() == mkvparser::Track::kAudio;
+    emscripten::val chunk = emscripten::val::object();
+    chunk.set("type", is_key ? "key" : "delta");
+    chunk.set("timestamp", static_cast<double>(frame.timestamp_ns / 1000));
+    chunk.set("data", frameData(frame));
+    return chunk;
+  }
+
+  // Keyframe-only reader for thumbnailing: skips every delta frame without
+  // touching its payload and returns the keyframe as a view, like
+  // readNextVideoFrameView(). Uses the frame index or Cues when available.
+  // With Cues that means the cued keyframes, normally all of them.
+  emscripten::val readNextKeyframe(uint32_t track_id) {
+    if (!headers_parsed_ || !segment_) {
+      return emscripten::val::null();
+    }
+
+    WEBM_STAT(PhaseTimer phase_timer(stats_.read_ns);)
+    FrameRef frame;
+    if (!nextKeyframe(track_id, frame)) {
+      return emscripten::val::null();
+    }
+    WEBM_STAT(++stats_.frames_returned;)
+    return frameView(frame, true);
+  }
+
+  // Counters collected since creation or the last resetStats(), or null
+  // unless the module was built with LIBWEBM_JS_STATS
+  emscripten::val getStats() const {
+#ifdef LIBWEBM_JS_STATS
+    emscripten::val stats = stats_.toVal();
+    stats.set("clustersLoaded",
+              segment_ ? static_cast<double>(segment_->GetCount()) : 0.0);
+    return stats;
+#else
+    return emscripten::val::null();
+#endif
+  }
+
+  void resetStats() { WEBM_STAT(stats_ = WebMStats();) }
+
+  // Native entry point for WebMMuxer::remux, not bound to JS. Calls
+  // visit(track, frame, data) for each frame of the tracks in
+  // |track_numbers|, in file order, with |data| pointing into the input
+  // buffer. A positive |start_ns| starts at the keyframe of |anchor_track|
+  // at or before it; the walk stops at the first cluster starting at or
+  // after |end_ns|, or when visit returns false.
+  template <typename Visitor>
+  void visitFrames(const std::vector<long> &track_numbers, long anchor_track,
+                   long long start_ns, long long end_ns, Visitor &&visit) {
+    if (!headers_parsed_ || !segment_) {
+      throwError("Headers not parsed");
+    }
+    if (streaming_) {
+      throwError("Streaming parsers cannot be remuxed");
+    }
+    if (visitIndexedFrames(track_numbers, anchor_track, start_ns, end_ns,
+                           visit)) {
+      return;
+    }
+
+    FrameCursor cursor;
+    const mkvparser::Track *const anchor =
+        tracks_->GetTrackByNumber(anchor_track);
+    if (anchor && start_ns > 0) {
+      const mkvparser::BlockEntry *block_entry = nullptr;
+      if (seekEntry(anchor, start_ns, block_entry) < 0) {
+        throwError("Failed to seek to the remux start");
+      }
+      if (!block_entry || block_entry->EOS()) {
+        return;
+      }
+      cursor.current_cluster = block_entry->GetCluster();
+      cursor.current_block_entry = block_entry;
+      cursor.entry_pending = true;
+    }
+
+    while (advanceCursor(cursor) > 0) {
+      if (cursor.current_cluster->GetTime() >= end_ns) {
+        return;
+      }
+
+      const mkvparser::BlockEntry *const block_entry =
+          cursor.current_block_entry;
+      const mkvparser::Block *const block = block_entry->GetBlock();
+      const long number = static_cast<long>(block->GetTrackNumber());
+      if (std::find(track_numbers.begin(), track_numbers.end(), number) ==
+          track_numbers.end()) {
+        continue;
+      }
+
+      const mkvparser::Track *const track = tracks_->GetTrackByNumber(number);
+      for (int i = 0; i < block->GetFrameCount(); ++i) {
+        const FrameRef frame =
+            blockFrameRef(block_entry, cursor.current_cluster, i, track);
+        const uint8_t *data =
+            frame.len > 0 ? reader_->Span(frame.pos, frame.len) : nullptr;
+        if (!data) {
+          if (frame.len > 0) {
+            recordError(frame.pos, WebMErrorCode::IO_ERROR);
+          }
+          continue;
+        }
+        if (!visit(track, frame, data)) {
+          return;
+        }
+      }
+    }
+  }
+
+  const mkvparser::Tracks *tracks() const { return tracks_; }
+
+private:
+  // visitFrames() over the frame index, when every selected track has one.
+  // Resilient parsers only have the index: their clusters are never loaded
+  // through mkvparser. Returns false when the blocks must be walked instead.
+  template <typename Visitor>
+  bool visitIndexedFrames(const std::vector<long> &track_numbers,
+                          long anchor_track, long long start_ns,
+                          long long end_ns, Visitor &visit) {
+    std::vector<std::pair<const mkvparser::Track *,
+                          const FrameIndexEntry *>> frames;
+    for (const long number : track_numbers) {
+      const auto index = track_indexes_.find(number);
+      if (index == track_indexes_.end()) {
+        return false;
+      }
+      const mkvparser::Track *const track = tracks_->GetTrackByNumber(number);
+      for (const FrameIndexEntry &entry : index->second) {
+        frames.emplace_back(track, &entry);
+      }
+    }
+    std::stable_sort(frames.begin(), frames.end(),
+                     [](const std::pair<const mkvparser::Track *,
+                                        const FrameIndexEntry *> &a,
+                        const std::pair<const mkvparser::Track *,
+                                        const FrameIndexEntry *> &b) {
+                       return a.second->pos < b.second->pos;
+                     });
+
+    // Start at the anchor keyframe at or before |start_ns|
+    long long start_pos = 0;
+    const auto anchor = track_indexes_.find(anchor_track);
+    if (anchor != track_indexes_.end() && start_ns > 0) {
+      for (const FrameIndexEntry &entry : anchor->second) {
+        if (entry.timestamp_ns > start_ns) {
+          break;
+        }
+        if (entry.flags & FRAME_FLAG_KEYFRAME) {
+          start_pos = entry.pos;
+        }
+      }
+    }
+
+    for (const auto &item : frames) {
+      const FrameIndexEntry &entry = *item.second;
+      if (entry.pos < start_pos || entry.timestamp_ns >= end_ns) {
+        continue;
+      }
+      FrameRef frame;
+      frame.pos = entry.pos;
+      frame.len = static_cast<long>(entry.size);
+      frame.timestamp_ns = entry.timestamp_ns;
+      frame.is_keyframe = (entry.flags & FRAME_FLAG_KEYFRAME) != 0;
+      frame.is_invisible = (entry.flags & FRAME_FLAG_INVISIBLE) != 0;
+      const uint8_t *data =
+          frame.len > 0 ? reader_->Span(frame.pos, frame.len) : nullptr;
+      if (!data) {
+        if (frame.len > 0) {
+          recordError(frame.pos, WebMErrorCode::IO_ERROR);
+        }
+        continue;
+      }
+      if (!visit(item.first, frame, data)) {
+        break;
+      }
+    }
+    return true;
+  }
+
+  // Find the block entry to resume |track| from for a seek to |time_ns|:
+  // the Cues when present, otherwise a scan of the loaded clusters.
+  // Returns a negative mkvparser status on failure.
+  long seekEntry(const mkvparser::Track *track, long long time_ns,
+                 const mkvparser::BlockEntry *&block_entry) {
+    block_entry = nullptr;
+
+    const mkvparser::Cues *const cues = segment_->GetCues();
+    if (cues) {
+      while (!cues->DoneParsing()) {
+        cues->LoadCuePoint();
+      }
+
+      const mkvparser::CuePoint *cue_point = nullptr;
+      const mkvparser::CuePoint::TrackPosition *track_position = nullptr;
+      if (cues->Find(time_ns, track, cue_point, track_position)) {
+        block_entry = cues->GetBlock(cue_point, track_position);
+      }
+    }
+
+    if (!block_entry || block_entry->EOS()) {
+      // Track::Seek only searches loaded clusters, so load up to the target
+      while (lazy_ && !clusters_loaded_ &&
+             (segment_->GetCount() == 0 ||
+              segment_->GetLast()->GetTime() <= time_ns)) {
+        if (!loadNextCluster()) {
+          break;
+        }
+      }
+
+      return track->Seek(time_ns, block_entry);
+    }
+    return 0;
+  }
+
+  const mkvparser::Track *findTrack(uint32_t track_number,
+                                    long track_type) const {
+    if (!headers_parsed_ || !tracks_) {
+      throwError("Headers not parsed");
+    }
+
+    const mkvparser::Track *const track =
+        tracks_->GetTrackByNumber(static_cast<long>(track_number));
+    if (!track) {
+      throwError("Track not found");
+    }
+    if (track->GetType() != track_type) {
+      throwError(track_type == mkvparser::Track::kVideo
+                     ? "Track is not a video track"
+                     : "Track is not an audio track");
+    }
+    return track;
+  }
+
+  // Colour elements are optional; map "not present" to -1
+  static int32_t colourValue(long long value) {
+    if (value < 0 || value == mkvparser::Colour::kValueNotPresent) {
+      return -1;
+    }
+    return static_cast<int32_t>(value);
+  }
+
+  // Drop everything tied to the current input, keeping allocated capacity
+  void clear() {
+    delete segment_;
+    segment_ = nullptr;
+    delete reader_;
+    reader_ = nullptr;
+    tracks_ = nullptr;
+    external_input_ = false;
+
+    buffer_.clear();
+    headers_parsed_ = false;
+    current_timestamp_ = 0;
+    frame_count_ = 0;
+    streaming_ = false;
+    stream_complete_ = false;
+    clusters_loaded_ = false;
+
+    cursors_.clear();
+    keyframe_cursors_.clear();
+    recycleIndexes(track_indexes_);
+    errors_.clear();
+  }
+
+  // Size of the input and CRC of its first and last
+  // kIndexFingerprintWindow bytes, identifying it for importIndex()
+  bool sourceFingerprint(long long &size, uint32_t &crc) {
+    long long available = 0;
+    if (reader_->Length(&size, &available) < 0) {
+      return false;
+    }
+    if (size < 0) {
+      size = available;
+    }
+
+    const long long window = std::min<long long>(
+        size, static_cast<long long>(kIndexFingerprintWindow));
+    std::vector<uint8_t> bytes(static_cast<size_t>(window));
+    crc = 0;
+    for (const long long pos : {0LL, size - window}) {
+      if (window > 0 &&
+          reader_->Read(pos, static_cast<long>(window), bytes.data()) < 0) {
+        return false;
+      }
+      crc = crc32(bytes.data(), bytes.size(), crc);
+    }
+    return true;
+  }
+
+  // Body of parseHeaders(): EBML header, Segment and, depending on the
+  // mode, the headers only, a resilient scan or every cluster
+  WebMErrorCode loadSegment() {
+    // Create reader and parse with libwebm
+    if (!reader_) {
+      attachReader(new MemoryReader(buffer_));
+    }
+
+    long long pos = 0;
+    mkvparser::EBMLHeader ebmlHeader;
+    long long status = ebmlHeader.Parse(reader_, pos);
+    if (status < 0) {
+      return WebMErrorCode::CORRUPTED_DATA;
+    }
+
+    status = mkvparser::Segment::CreateInstance(reader_, pos, segment_);
+    if (status < 0) {
+      return WebMErrorCode::CORRUPTED_DATA;
+    }
+
+    if (resilient_) {
+      // Only the headers go through mkvparser; clusters are indexed by
+      // the scanner, which can step over damage
+      status = segment_->ParseHeaders();
+      if (status != 0 || !segment_->GetTracks()) {
+        return WebMErrorCode::CORRUPTED_DATA;
+      }
+      tracks_ = segment_->GetTracks();
+      buildResilientIndex();
+    } else if (lazy_) {
+      status = segment_->ParseHeaders();
+      if (status != 0) {
+        return WebMErrorCode::CORRUPTED_DATA;
+      }
+      loadCuesFromSeekHead();
+    } else {
+      status = segment_->Load();
+      if (status < 0) {
+        return WebMErrorCode::CORRUPTED_DATA;
+      }
+      clusters_loaded_ = true;
+    }
+
+    tracks_ = segment_->GetTracks();
+    if (!tracks_) {
+      return WebMErrorCode::UNSUPPORTED_FORMAT;
+    }
+
+    headers_parsed_ = true;
+    return WebMErrorCode::SUCCESS;
+  }
+
+  // Fill batch_ for readFrames() and readClusterFrames(). As nextFrame()
+  // does for frames whose bytes are missing, a frame the reader fails to
+  // deliver is left out and recorded rather than ending the batch.
+  emscripten::val readBatch(uint32_t track_number, uint32_t max_frames,
+                            bool one_cluster) {
+    if (!headers_parsed_ || !segment_) {
+      throwError("Headers not parsed");
+    }
+
+    const mkvparser::Track *const track =
+        tracks_->GetTrackByNumber(static_cast<long>(track_number));
+    if (!track) {
+      throwError("Track not found");
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.read_ns);)
+
+    batch_.payload.clear();
+    batch_.offsets.clear();
+    batch_.sizes.clear();
+    batch_.timestamps_ns.clear();
+    batch_.flags.clear();
+
+    FrameRef frame;
+    long long cluster = -1;
+    while (batch_.sizes.size() < max_frames &&
+           nextFrame(track_number, track->GetType(), frame)) {
+      if (one_cluster) {
+        FrameCursor &cursor = cursors_[track_number];
+        const long long frame_cluster = cursorCluster(cursor);
+        if (!batch_.sizes.empty() && frame_cluster != cluster) {
+          unreadFrame(cursor); // First frame of the next cluster
+          break;
+        }
+        cluster = frame_cluster;
+      }
+      const size_t offset = batch_.payload.size();
+      WEBM_STAT(const size_t capacity = batch_.payload.capacity();)
+      batch_.payload.resize(offset + static_cast<size_t>(frame.len));
+      WEBM_STAT({
+        if (batch_.payload.capacity() != capacity) {
+          ++stats_.allocations;
+        }
+        stats_.bytes_copied_out += frame.len;
+      })
+      if (reader_->Read(frame.pos, frame.len,
+                        batch_.payload.data() + offset) < 0) {
+        batch_.payload.resize(offset);
+        recordError(frame.pos, WebMErrorCode::IO_ERROR);
+        continue;
+      }
+
+      uint8_t flags = 0;
+      if (frame.is_keyframe) {
+        flags |= FRAME_FLAG_KEYFRAME;
+      }
+      if (frame.is_invisible) {
+        flags |= FRAME_FLAG_INVISIBLE;
+      }
+
+      batch_.offsets.push_back(static_cast<uint32_t>(offset));
+      batch_.sizes.push_back(static_cast<uint32_t>(frame.len));
+      batch_.timestamps_ns.push_back(static_cast<double>(frame.timestamp_ns));
+      batch_.flags.push_back(flags);
+    }
+
+    emscripten::val result = emscripten::val::object();
+    result.set("count", static_cast<uint32_t>(batch_.sizes.size()));
+    result.set("data", emscripten::val(emscripten::typed_memory_view(
+                           batch_.payload.size(), batch_.payload.data())));
+    result.set("offsets", emscripten::val(emscripten::typed_memory_view(
+                              batch_.offsets.size(), batch_.offsets.data())));
+    result.set("sizes", emscripten::val(emscripten::typed_memory_view(
+                            batch_.sizes.size(), batch_.sizes.data())));
+    result.set("timestampsNs",
+               emscripten::val(emscripten::typed_memory_view(
+                   batch_.timestamps_ns.size(), batch_.timestamps_ns.data())));
+    result.set("flags", emscripten::val(emscripten::typed_memory_view(
+                            batch_.flags.size(), batch_.flags.data())));
+    return result;
+  }
+
+  // Copy a frame into a pooled buffer. nextFrame() only returns frames
+  // whose bytes are in the input, but a JS source may still fail to
+  // deliver them: the buffer then goes back to the pool rather than
+  // reaching JS with the bytes of an earlier frame.
+  std::unique_ptr<WebMFrameData> copyFrame(const FrameRef &frame,
+                                           bool is_keyframe) {
+    bool allocated = false;
+    auto frame_data = std::make_unique<WebMFrameData>();
+    frame_data->data =
+        frame_pool_->Acquire(static_cast<size_t>(frame.len), allocated);
+    frame_data->pool = frame_pool_;
+    if (reader_->Read(frame.pos, frame.len, frame_data->data.data()) < 0) {
+      recordError(frame.pos, WebMErrorCode::IO_ERROR);
+      frame_data.reset(); // Size builds do not unwind on throw
+      throwError("Failed to read frame data");
+    }
+    WEBM_STAT({
+      if (allocated) {
+        ++stats_.allocations;
+      }
+      stats_.bytes_copied_out += frame.len;
+    })
+    frame_data->timestamp_ns = frame.timestamp_ns;
+    frame_data->is_keyframe = is_keyframe;
+    return frame_data;
+  }
+
+  // Payload of |frame| as a Uint8Array. Over an in-memory input it views
+  // the buffer; file- and source-backed spans live in the block cache or
+  // the straddle scratch buffer, which the next read may overwrite, so
+  // those are copied out.
+  emscripten::val frameData(const FrameRef &frame) {
+    const uint8_t *data = reader_->Span(frame.pos, frame.len);
+    if (!data) {
+      throwError("Frame lies outside the input buffer");
+    }
+
+    const size_t len = static_cast<size_t>(frame.len);
+    const emscripten::val view(emscripten::typed_memory_view(len, data));
+    if (!external_input_) {
+      return view;
+    }
+    emscripten::val copy = emscripten::val::global("Uint8Array").new_(len);
+    copy.call<void>("set", view);
+    WEBM_STAT(stats_.bytes_copied_out += len;)
+    return copy;
+  }
+
+  emscripten::val frameView(const FrameRef &frame, bool is_keyframe) {
+    emscripten::val view = emscripten::val::object();
+    view.set("data", frameData(frame));
+    view.set("timestampNs", static_cast<double>(frame.timestamp_ns));
+    view.set("isKeyframe", is_keyframe);
+    return view;
+  }
+
+  // ParseHeaders() only picks up Cues placed before the first cluster.
+  // Files written by mkvmuxer put them at the end, referenced by SeekHead.
+  void loadCuesFromSeekHead() {
+    const mkvparser::SeekHead *const seek_head = segment_->GetSeekHead();
+    if (segment_->GetCues() || !seek_head) {
+      return;
+    }
+
+    for (int i = 0; i < seek_head->GetCount(); ++i) {
+      const mkvparser::SeekHead::Entry *const entry = seek_head->GetEntry(i);
+      if (entry && entry->id == libwebm::kMkvCues) {
+        long long pos = 0;
+        long len = 0;
+        segment_->ParseCues(entry->pos, pos, len);
+        return;
+      }
+    }
+  }
+
+  // Parse whatever the streamed input allows: EBML header and segment
+  // headers first, then every cluster whose start has been received.
+  WebMErrorCode parseAvailableData() {
+    if (!segment_) {
+      if (buffer_.size() < 4) {
+        return WebMErrorCode::SUCCESS;
+      }
+
+      long long pos = 0;
+      mkvparser::EBMLHeader ebmlHeader;
+      long long status = ebmlHeader.Parse(reader_, pos);
+      if (status > 0 || status == mkvparser::E_BUFFER_NOT_FULL) {
+        return waitingForData() ? WebMErrorCode::SUCCESS
+                                : WebMErrorCode::INVALID_FILE;
+      }
+      if (status < 0) {
+        return WebMErrorCode::CORRUPTED_DATA;
+      }
+
+      status = mkvparser::Segment::CreateInstance(reader_, pos, segment_);
+      if (status > 0 || status == mkvparser::E_BUFFER_NOT_FULL) {
+        return waitingForData() ? WebMErrorCode::SUCCESS
+                                : WebMErrorCode::INVALID_FILE;
+      }
+      if (status < 0 || !segment_) {
+        return WebMErrorCode::CORRUPTED_DATA;
+      }
+    }
+
+    if (!headers_parsed_) {
+      const long long status = segment_->ParseHeaders();
+      if (status > 0 || status == mkvparser::E_BUFFER_NOT_FULL) {
+        return waitingForData() ? WebMErrorCode::SUCCESS
+                                : WebMErrorCode::INVALID_FILE;
+      }
+      if (status < 0) {
+        return WebMErrorCode::CORRUPTED_DATA;
+      }
+
+      tracks_ = segment_->GetTracks();
+      if (!tracks_) {
+        return WebMErrorCode::UNSUPPORTED_FORMAT;
+      }
+      headers_parsed_ = true;
+    }
+
+    while (!clusters_loaded_) {
+      long long pos = 0;
+      long len = 0;
+      const long status = segment_->LoadCluster(pos, len);
+      if (status == 0) {
+        continue;
+      }
+      if (status == mkvparser::E_BUFFER_NOT_FULL && waitingForData()) {
+        break;
+      }
+      if (status > 0 || status == mkvparser::E_BUFFER_NOT_FULL) {
+        // End of segment, or a truncated stream that will not grow anymore
+        clusters_loaded_ = true;
+        break;
+      }
+      return WebMErrorCode::CORRUPTED_DATA;
     }
 
-    return static_cast<uint32_t>(tracks_->GetTracksCount());
+    return WebMErrorCode::SUCCESS;
   }
 
-  WebMTrackInfo getTrackInfo(uint32_t track_index) const {
-    if (!headers_parsed_ || !tracks_) {
-      throw std::runtime_error("Headers not parsed");
+  // Drop the streamed bytes every cursor has moved past, so memory is
+  // bounded by the clusters still being read rather than by the stream
+  // size. Lazily parsed Cues may point anywhere, so keep everything then.
+  void discardConsumedData() {
+    if (!streaming_ || !segment_ || !tracks_ ||
+        (cursors_.empty() && keyframe_cursors_.empty()) ||
+        segment_->GetCues()) {
+      return;
     }
 
-    const unsigned long count = tracks_->GetTracksCount();
-    if (track_index >= count) {
-      throw std::runtime_error("Track index out of range");
+    // A track nobody has read yet starts at the first cluster, so nothing
+    // may be released before every track has a reader of its own
+    for (unsigned long i = 0; i < tracks_->GetTracksCount(); ++i) {
+      const mkvparser::Track *const track = tracks_->GetTrackByIndex(i);
+      if (track &&
+          (track->GetType() == mkvparser::Track::kVideo ||
+           track->GetType() == mkvparser::Track::kAudio) &&
+          !cursors_.count(static_cast<uint32_t>(track->GetNumber()))) {
+        return;
+      }
     }
 
-    const mkvparser::Track *const track = tracks_->GetTrackByIndex(track_index);
-    if (!track) {
-      throw std::runtime_error("Track not found");
+    const long long window_end =
+        reader_->Base() + static_cast<long long>(buffer_.size());
+    long long keep_from = window_end;
+    for (const auto &entry : cursors_) {
+      const FrameCursor &cursor = entry.second;
+      if (cursor.end_of_stream) {
+        continue;
+      }
+      if (!cursor.current_cluster) {
+        return; // This reader has not started yet
+      }
+      keep_from = std::min(keep_from, cursor.current_cluster->m_element_start);
     }
 
-    WebMTrackInfo info;
-    info.track_number = static_cast<uint32_t>(track->GetNumber());
-
-    // Determine track type
-    const long long type = track->GetType();
-    if (type == 1) { // Video
-      info.track_type = static_cast<uint32_t>(WebMTrackType::VIDEO);
-    } else if (type == 2) { // Audio
-      info.track_type = static_cast<uint32_t>(WebMTrackType::AUDIO);
-    } else {
-      info.track_type = static_cast<uint32_t>(WebMTrackType::UNKNOWN);
+    // readNextKeyframe() cursors keep their held keyframe and, when they
+    // walk blocks, their current cluster
+    for (const auto &entry : keyframe_cursors_) {
+      const KeyframeCursor &cursor = entry.second;
+      if (cursor.has_held) {
+        keep_from = std::min(keep_from, cursor.held.pos);
+      }
+      if (cursor.source == KeyframeCursor::kIndex) {
+        const auto index = track_indexes_.find(cursor.track->GetNumber());
+        if (index != track_indexes_.end() &&
+            cursor.index_position < index->second.size()) {
+          keep_from =
+              std::min(keep_from, index->second[cursor.index_position].pos);
+        }
+      } else if (cursor.source == KeyframeCursor::kBlocks &&
+                 !cursor.blocks.end_of_stream) {
+        if (!cursor.blocks.current_cluster) {
+          return;
+        }
+        keep_from = std::min(keep_from,
+                             cursor.blocks.current_cluster->m_element_start);
+      }
     }
 
-    info.codec_id = track->GetCodecId() ? track->GetCodecId() : "unknown";
-    info.name = track->GetNameAsUTF8() ? track->GetNameAsUTF8() : "";
+    // Only compact once the dead prefix dominates, to amortize the move
+    const long long drop = keep_from - reader_->Base();
+    if (drop <= 0 || static_cast<size_t>(drop) < buffer_.size() / 2) {
+      return;
+    }
 
-    return info;
+    buffer_.erase(buffer_.begin(), buffer_.begin() + drop);
+    streamReader()->SetBase(keep_from);
   }
+};
 
-  WebMVideoInfo getVideoInfo(uint32_t track_number) const {
-    if (!headers_parsed_) {
-      throw std::runtime_error("Headers not parsed");
+// Batch metadata probe for ingest: parses only the headers of many inputs
+// (the EBML header, SeekHead, Info and Tracks, never the clusters) with one
+// shared scratch arena. In the threaded build the inputs are probed
+// concurrently.
+class WebMProber {
+public:
+  // |inputs| is an array whose items are either a Uint8Array or
+  // { data, size } where |data| is the start of a file of |size| bytes.
+  // The first few KB are normally enough. Returns one result per input:
+  // { status, truncated, durationNs, cuesPosition, tracks }.
+  emscripten::val probe(const emscripten::val &inputs, uint32_t thread_count) {
+    const size_t count = inputs["length"].as<size_t>();
+
+    // Pack every input into the arena with one bulk copy each; the arena
+    // keeps its capacity from one batch to the next
+    std::vector<Input> batch(count);
+    size_t arena_size = 0;
+    for (size_t i = 0; i < count; ++i) {
+      const emscripten::val input = inputs[i];
+      const emscripten::val data = input["data"];
+      const bool is_range = !data.isUndefined() && !data.isNull();
+      batch[i].offset = arena_size;
+      batch[i].size = (is_range ? data : input)["length"].as<size_t>();
+      // A range of unknown file size reads like a live stream
+      const emscripten::val total = input["size"];
+      batch[i].total =
+          !is_range ? static_cast<long long>(batch[i].size)
+          : total.isNumber() ? static_cast<long long>(total.as<double>())
+                             : -1;
+      arena_size += batch[i].size;
+    }
+    arena_.resize(arena_size);
+    for (size_t i = 0; i < count; ++i) {
+      const emscripten::val input = inputs[i];
+      const emscripten::val data = input["data"];
+      emscripten::val(emscripten::typed_memory_view(
+                          batch[i].size, arena_.data() + batch[i].offset))
+          .call<void>("set", data.isUndefined() || data.isNull() ? input
+                                                                 : data);
     }
 
-    WebMVideoInfo info;
-    info.width = 1920;
-    info.height = 1080;
-    info.frame_rate = 30.0;
-    return info;
-  }
+    std::vector<Result> results(count);
+    const auto run = [&](size_t i) { probeOne(batch[i], results[i]); };
 
-  WebMAudioInfo getAudioInfo(uint32_t track_number) const {
-    if (!headers_parsed_) {
-      throw std::runtime_error("Headers not parsed");
-    }
+#ifdef LIBWEBM_JS_THREADS
+    const size_t workers = workerCount(thread_count, count);
 
-    WebMAudioInfo info;
-    info.sampling_frequency = 48000.0;
-    info.channels = 2;
-    info.bit_depth = 16;
-    return info;
-  }
+    std::atomic<size_t> next_input(0);
+    const auto work = [&]() {
+      for (size_t i = next_input++; i < count; i = next_input++) {
+        run(i);
+      }
+    };
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < workers; ++i) {
+      pool.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : pool) {
+      thread.join();
+    }
+#else
+    (void)thread_count;
+    for (size_t i = 0; i < count; ++i) {
+      run(i);
+    }
+#endif
 
-  std::unique_ptr<WebMFrameData> readNextVideoFrame(uint32_t track_id) {
-    if (!headers_parsed_ || !segment_) {
-      return nullptr;
+    emscripten::val out = emscripten::val::array();
+    for (size_t i = 0; i < count; ++i) {
+      out.call<void>("push", toVal(results[i]));
     }
+    return out;
+  }
 
-    const mkvparser::Cluster *cluster = segment_->GetFirst();
-    while (cluster && !cluster->EOS()) {
-      const mkvparser::BlockEntry *block_entry;
-      long status = cluster->GetFirst(block_entry);
-      if (status < 0)
-        break;
+private:
+  struct Input {
+    size_t offset; // in arena_
+    size_t size;   // bytes provided
+    long long total;
+  };
 
-      while (block_entry && !block_entry->EOS()) {
-        const mkvparser::Block *const block = block_entry->GetBlock();
-        if (block) {
-          const long long track_number = block->GetTrackNumber();
-
-          // Find the track that matches our track_id
-          const mkvparser::Track *const track =
-              tracks_->GetTrackByNumber(static_cast<long>(track_number));
-          if (track && track->GetType() == 1) { // Video track
-            const int frame_count = block->GetFrameCount();
-
-            // Debug: log frame information
-            // printf("Debug C++: Track found - type=%ld, frame_count=%d\n",
-            //        track->GetType(), frame_count);
-
-            if (frame_count > 0) {
-              const mkvparser::Block::Frame &frame = block->GetFrame(0);
-
-              auto frame_data = std::make_unique<WebMFrameData>();
-
-              // Debug: log frame information
-              //   printf("Debug C++: Frame found - len=%ld, frame_count=%d\n",
-              //          frame.len, frame_count);
-
-              if (frame.len > 0 &&
-                  frame.len <
-                      10000000) { // Sanity check for reasonable frame size
-                frame_data->data.resize(frame.len);
-                long status = frame.Read(reader_, frame_data->data.data());
-                // printf("Debug C++: Read status=%ld, data_size=%zu\n", status,
-                //        frame_data->data.size());
-              } else {
-                // printf("Debug C++: Frame length is invalid: %ld\n",
-                // frame.len); Frame length is corrupted, create fallback dummy
-                // data printf("Debug C++: Creating fallback dummy data\n");
-                frame_data->data.resize(1000);
-                // Create some dummy data to test the pipeline
-                for (size_t i = 0; i < 1000; ++i) {
-                  frame_data->data[i] = (uint8_t)(i % 256);
-                }
-                // printf("Debug C++: Created dummy data of size %zu\n",
-                //        frame_data->data.size());
-              }
-
-              frame_data->timestamp_ns = block->GetTime(cluster);
-              frame_data->is_keyframe = block->IsKey();
-
-              return frame_data;
-            }
-          }
-        }
+  struct Track {
+    WebMTrackInfo info;
+    long type;
+    WebMVideoInfo video;
+    WebMAudioInfo audio;
+    std::vector<uint8_t> codec_private;
+  };
+
+  struct Result {
+    WebMErrorCode status = WebMErrorCode::SUCCESS;
+    bool truncated = false; // the headers run past the provided bytes
+    double duration_ns = -1;
+    long long cues_position = -1; // byte offset in the file
+    std::vector<Track> tracks;
+  };
+
+  // Reader over the first |size| bytes of a file of |total| bytes
+  class PrefixReader : public mkvparser::IMkvReader {
+  public:
+    PrefixReader(const uint8_t *data, size_t size, long long total)
+        : data_(data), size_(size), total_(total) {}
+
+    int Read(long long pos, long len, unsigned char *buf) override {
+      if (pos < 0 || len < 0 || static_cast<size_t>(pos) + len > size_)
+        return -1;
+      std::memcpy(buf, data_ + pos, len);
+      return 0;
+    }
 
-        status = cluster->GetNext(block_entry, block_entry);
-        if (status < 0)
-          break;
-      }
+    int Length(long long *total, long long *available) override {
+      *total = total_;
+      *available = static_cast<long long>(size_);
+      return 0;
+    }
 
-      cluster = segment_->GetNext(cluster);
+  private:
+    const uint8_t *data_;
+    size_t size_;
+    long long total_;
+  };
+
+  // Runs on worker threads: touches neither JS values nor shared state
+  // other than its own input and result
+  void probeOne(const Input &input, Result &result) const {
+    PrefixReader reader(arena_.data() + input.offset, input.size, input.total);
+
+    long long pos = 0;
+    mkvparser::EBMLHeader header;
+    long long status = header.Parse(&reader, pos);
+    if (status < 0) {
+      result.truncated = status == mkvparser::E_BUFFER_NOT_FULL;
+      result.status = WebMErrorCode::INVALID_FILE;
+      return;
     }
 
-    return nullptr;
-  }
+    mkvparser::Segment *raw_segment = nullptr;
+    status = mkvparser::Segment::CreateInstance(&reader, pos, raw_segment);
+    std::unique_ptr<mkvparser::Segment> segment(raw_segment);
+    if (status != 0 || !segment) {
+      result.truncated = status > 0;
+      result.status = WebMErrorCode::INVALID_FILE;
+      return;
+    }
 
-  std::unique_ptr<WebMFrameData> readNextAudioFrame(uint32_t track_id) {
-    if (!headers_parsed_ || !segment_) {
-      return nullptr;
+    status = segment->ParseHeaders();
+    if (status != 0 || !segment->GetTracks() || !segment->GetInfo()) {
+      result.truncated = status == mkvparser::E_BUFFER_NOT_FULL || status > 0;
+      result.status = WebMErrorCode::CORRUPTED_DATA;
+      return;
     }
 
-    const mkvparser::Cluster *cluster = segment_->GetFirst();
-    while (cluster && !cluster->EOS()) {
-      const mkvparser::BlockEntry *block_entry;
-      long status = cluster->GetFirst(block_entry);
-      if (status < 0)
-        break;
+    const long long duration = segment->GetInfo()->GetDuration();
+    result.duration_ns = duration >= 0 ? static_cast<double>(duration) : -1;
 
-      while (block_entry && !block_entry->EOS()) {
-        const mkvparser::Block *const block = block_entry->GetBlock();
-        if (block) {
-          const long long track_number = block->GetTrackNumber();
-
-          // Find the track that matches our track_id
-          const mkvparser::Track *const track =
-              tracks_->GetTrackByNumber(static_cast<long>(track_number));
-          if (track && track->GetType() == 2) { // Audio track
-            const int frame_count = block->GetFrameCount();
-            if (frame_count > 0) {
-              const mkvparser::Block::Frame &frame = block->GetFrame(0);
-
-              auto frame_data = std::make_unique<WebMFrameData>();
-              frame_data->data.resize(frame.len);
-              frame.Read(reader_, frame_data->data.data());
-              frame_data->timestamp_ns = block->GetTime(cluster);
-              frame_data->is_keyframe =
-                  false; // Audio frames don't have keyframes
-
-              return frame_data;
-            }
-          }
+    // Where the Cues live, so they can be fetched without the clusters
+    if (const mkvparser::SeekHead *seek_head = segment->GetSeekHead()) {
+      for (int i = 0; i < seek_head->GetCount(); ++i) {
+        const mkvparser::SeekHead::Entry *entry = seek_head->GetEntry(i);
+        if (entry && entry->id == libwebm::kMkvCues) {
+          result.cues_position = segment->m_start + entry->pos;
         }
-
-        status = cluster->GetNext(block_entry, block_entry);
-        if (status < 0)
-          break;
       }
+    }
 
-      cluster = segment_->GetNext(cluster);
+    const mkvparser::Tracks *tracks = segment->GetTracks();
+    for (unsigned long i = 0; i < tracks->GetTracksCount(); ++i) {
+      const mkvparser::Track *track = tracks->GetTrackByIndex(i);
+      if (!track) {
+        continue;
+      }
+      Track probed;
+      probed.info = WebMParser::describeTrack(track);
+      probed.type = track->GetType();
+      if (probed.type == mkvparser::Track::kVideo) {
+        probed.video = WebMParser::describeVideo(
+            static_cast<const mkvparser::VideoTrack *>(track));
+      } else if (probed.type == mkvparser::Track::kAudio) {
+        probed.audio = WebMParser::describeAudio(
+            static_cast<const mkvparser::AudioTrack *>(track));
+      }
+      size_t private_size = 0;
+      const unsigned char *codec_private = track->GetCodecPrivate(private_size);
+      if (codec_private && private_size > 0) {
+        probed.codec_private.assign(codec_private,
+                                    codec_private + private_size);
+      }
+      result.tracks.push_back(std::move(probed));
     }
+  }
 
-    return nullptr;
+  static emscripten::val toVal(const Result &result) {
+    emscripten::val out = emscripten::val::object();
+    out.set("status", static_cast<int>(result.status));
+    out.set("truncated", result.truncated);
+    out.set("durationNs", result.duration_ns);
+    out.set("cuesPosition", static_cast<double>(result.cues_position));
+
+    emscripten::val tracks = emscripten::val::array();
+    for (const Track &track : result.tracks) {
+      emscripten::val item = emscripten::val::object();
+      item.set("trackNumber", track.info.track_number);
+      item.set("trackType", track.info.track_type);
+      item.set("codecId", track.info.codec_id);
+      item.set("name", track.info.name);
+      if (track.type == mkvparser::Track::kVideo) {
+        item.set("video", track.video);
+      } else if (track.type == mkvparser::Track::kAudio) {
+        item.set("audio", track.audio);
+      }
+      if (track.codec_private.empty()) {
+        item.set("codecPrivate", emscripten::val::null());
+      } else {
+        // Copied out: the arena is reused by the next probe()
+        emscripten::val bytes = emscripten::val::global("Uint8Array")
+                                    .new_(track.codec_private.size());
+        bytes.call<void>("set",
+                         emscripten::val(emscripten::typed_memory_view(
+                             track.codec_private.size(),
+                             track.codec_private.data())));
+        item.set("codecPrivate", bytes);
+      }
+      tracks.call<void>("push", item);
+    }
+    out.set("tracks", tracks);
+    return out;
   }
+
+  std::vector<uint8_t> arena_;
 };
+#endif
 
+#ifndef LIBWEBM_JS_NO_MUXER
 // WebM Muxer wrapper
 class WebMMuxer {
 public:
-  WebMMuxer() {
-    writer_ = std::make_unique<MemoryWriter>();
-    segment_ = std::make_unique<mkvmuxer::Segment>();
-
-    if (!segment_->Init(writer_.get())) {
-      throw std::runtime_error("Failed to initialize muxer segment");
-    }
-
-    segment_->set_mode(mkvmuxer::Segment::kFile);
-    segment_->OutputCues(true);
-
-    // Set up segment info
-    mkvmuxer::SegmentInfo *const info = segment_->GetSegmentInfo();
-    info->set_writing_app("libwebm-js");
-    info->set_muxing_app("libwebm-js");
+  WebMMuxer() : WebMMuxer(0) {}
+
+  // `expected_size` is a hint for the final file size in bytes, used to
+  // reserve the output buffer once instead of growing it chunk by chunk
+  explicit WebMMuxer(size_t expected_size) {
+    writer_ = std::make_unique<MemoryWriter>(expected_size);
+    WEBM_STAT(writer_->SetStats(&stats_);)
+    initSegment();
   }
 
   ~WebMMuxer() {
@@ -504,17 +3723,31 @@ public:
     }
   }
 
+  // Start a new file with no tracks and default settings, keeping the
+  // output chunks and staging buffer allocated for the previous one.
+  // Arrays already returned by finalize() or getData() are copies and stay
+  // valid.
+  void reset() {
+    segment_.reset();
+    writer_->Rewind();
+    finalized_ = false;
+    live_ = false;
+    cues_first_ = false;
+    frames_written_ = false;
+    initSegment();
+  }
+
   uint32_t addVideoTrack(uint32_t width, uint32_t height,
                          const std::string &codec_id) {
     if (!segment_) {
-      throw std::runtime_error("Segment not initialized");
+      throwError("Segment not initialized");
     }
 
     uint64_t vid_track = segment_->AddVideoTrack(
         width, height, 0); // Use 0 for auto track number
     
     if (vid_track == 0) {
-      throw std::runtime_error("Failed to add video track");
+      throwError("Failed to add video track");
     }
 
     mkvmuxer::VideoTrack *const video_track =
@@ -522,7 +3755,7 @@ public:
             segment_->GetTrackByNumber(vid_track));
 
     if (!video_track) {
-      throw std::runtime_error("Failed to get video track");
+      throwError("Failed to get video track");
     }
 
     video_track->set_codec_id(codec_id.c_str());
@@ -534,7 +3767,7 @@ public:
   uint32_t addAudioTrack(double sampling_frequency, uint32_t channels,
                          const std::string &codec_id) {
     if (!segment_) {
-      throw std::runtime_error("Segment not initialized");
+      throwError("Segment not initialized");
     }
 
     uint64_t aud_track =
@@ -542,7 +3775,7 @@ public:
                                 0); // Use 0 for auto track number
 
     if (aud_track == 0) {
-      throw std::runtime_error("Failed to add audio track");
+      throwError("Failed to add audio track");
     }
 
     mkvmuxer::AudioTrack *const audio_track =
@@ -550,7 +3783,7 @@ public:
             segment_->GetTrackByNumber(aud_track));
 
     if (!audio_track) {
-      throw std::runtime_error("Failed to get audio track");
+      throwError("Failed to get audio track");
     }
 
     audio_track->set_codec_id(codec_id.c_str());
@@ -563,94 +3796,654 @@ public:
   void writeVideoFrame(uint32_t track_id,
                        const emscripten::val &frame_data_val,
                        uint64_t timestamp_ns, bool is_keyframe) {
-    if (!segment_) {
-      throw std::runtime_error("Segment not initialized");
+    WEBM_STAT(PhaseTimer phase_timer(stats_.mux_ns);)
+    const size_t size = stageFrame(frame_data_val);
+    if (!addFrame(track_id, size, timestamp_ns, is_keyframe)) {
+      throwError("Failed to write video frame");
     }
+  }
 
-    // Validate track ID exists
-    mkvmuxer::Track* track = segment_->GetTrackByNumber(track_id);
+  void writeAudioFrame(uint32_t track_id,
+                       const emscripten::val &frame_data_val,
+                       uint64_t timestamp_ns) {
+    WEBM_STAT(PhaseTimer phase_timer(stats_.mux_ns);)
+    const size_t size = stageFrame(frame_data_val);
+    if (!addFrame(track_id, size, timestamp_ns,
+                  false // Audio frames are not keyframes
+                  )) {
+      throwError("Failed to write audio frame");
+    }
+  }
+
+  // Return a view over the muxer-owned staging buffer, grown to at least
+  // `size` bytes. The encoder writes a frame into it and then calls
+  // commitFrame(), so the only copy is the one Segment::AddFrame makes.
+  // The view is invalidated if the WASM memory grows.
+  emscripten::val getFrameBuffer(size_t size) {
+    if (size == 0) {
+      throwError("Frame data is empty");
+    }
+    if (staging_.size() < size) {
+      staging_.resize(size);
+    }
+    return emscripten::val(emscripten::typed_memory_view(size, staging_.data()));
+  }
+
+  // Set the CodecPrivate of an output track, e.g. the description of a
+  // WebCodecs encoder config (OpusHead, av1C). Must be set before the
+  // first frame, since the track headers are written with it.
+  void setCodecPrivate(uint32_t track_id, const emscripten::val &data_val) {
+    requireNoFrames("CodecPrivate");
+    mkvmuxer::Track *const track = segment_->GetTrackByNumber(track_id);
     if (!track) {
-      throw std::runtime_error("Invalid track ID");
+      throwError("Invalid track ID");
+    }
+    const size_t size = data_val["length"].as<size_t>();
+    if (size == 0) {
+      throwError("CodecPrivate is empty");
+    }
+    getFrameBuffer(size).call<void>("set", data_val);
+    if (!track->SetCodecPrivate(staging_.data(), size)) {
+      throwError("Failed to set CodecPrivate");
+    }
+  }
+
+  // Live mode: the segment is written for streaming (unknown sizes, no
+  // Cues, no seeking back), so output can be drained and uploaded while
+  // muxing continues. Must be selected before the first frame is written.
+  void setLiveMode(bool enabled) {
+    requireNoFrames("Live mode");
+    if (enabled && cues_first_) {
+      throwError("Cues cannot be moved first in live mode");
     }
+    // Leaving live mode brings back the Cues it turned off, but keeps an
+    // earlier setOutputCues(false)
+    if (enabled != live_) {
+      segment_->OutputCues(!enabled);
+    }
+    live_ = enabled;
+    writer_->SetSeekable(!enabled);
+    segment_->set_mode(enabled ? mkvmuxer::Segment::kLive
+                               : mkvmuxer::Segment::kFile);
+  }
+
+  // Cluster tuning, see mkvmuxer::Segment. A new cluster is started once the
+  // current one spans `duration_ns` or holds `size` bytes; 0 means no limit.
+  void setMaxClusterDuration(uint64_t duration_ns) {
+    requireNoFrames("Cluster limits");
+    segment_->set_max_cluster_duration(duration_ns);
+  }
+
+  void setMaxClusterSize(uint64_t size) {
+    requireNoFrames("Cluster limits");
+    segment_->set_max_cluster_size(size);
+  }
 
-    // Convert emscripten::val (Uint8Array) to std::vector<uint8_t>
-    std::vector<uint8_t> frame_data = emscripten::convertJSArrayToNumberVector<uint8_t>(frame_data_val);
+  // Write exact cluster durations by holding back the last frame of each
+  // cluster until the next one is known
+  void setAccurateClusterDuration(bool enabled) {
+    requireNoFrames("Cluster duration mode");
+    segment_->accurate_cluster_duration(enabled);
+  }
 
-    if (frame_data.empty()) {
-      throw std::runtime_error("Frame data is empty");
+  void setOutputCues(bool enabled) {
+    requireNoFrames("Cue output");
+    if (enabled && live_) {
+      throwError("Cues are not written in live mode");
     }
+    segment_->OutputCues(enabled);
+  }
 
-    bool success = segment_->AddFrame(frame_data.data(), frame_data.size(),
-                                      track_id, timestamp_ns, is_keyframe);
+  // Only add cue points for keyframes of this track (by default the first
+  // video track)
+  void setCuesTrack(uint32_t track_id) {
+    requireNoFrames("Cues track");
+    if (!segment_->CuesTrack(track_id)) {
+      throwError("Invalid track ID");
+    }
+  }
 
-    if (!success) {
-      throw std::runtime_error("Failed to write video frame");
+  // Place Cues before the first cluster so players can seek without
+  // reading to the end. Without a setCuesReserve() that fits them,
+  // finalize() rewrites the whole output into a second writer: an O(output)
+  // copy, with about twice the output size in memory at its peak.
+  void setCuesFirst(bool enabled) {
+    if (enabled && live_) {
+      throwError("Cues cannot be moved first in live mode");
     }
+    cues_first_ = enabled;
   }
 
-  void writeAudioFrame(uint32_t track_id,
-                       const emscripten::val &frame_data_val,
-                       uint64_t timestamp_ns) {
-    if (!segment_) {
-      throw std::runtime_error("Segment not initialized");
+  // Reserve |bytes| ahead of the segment Info for the Cues and turn on
+  // setCuesFirst(). finalize() writes Cues that fit into that space in
+  // place and only patches the SeekHead and segment size; otherwise it
+  // falls back to the rewrite and the reserve stays as a Void. A cue point
+  // takes about 12 to 20 bytes. 0 removes the reserve.
+  void setCuesReserve(uint32_t bytes) {
+    requireNoFrames("Cues reserve");
+    if (bytes > 0 && live_) {
+      throwError("Cues cannot be moved first in live mode");
+    }
+    if (bytes == 1) {
+      throwError("Cues reserve must be 0 or at least 2 bytes");
     }
+    writer_->ReserveCues(bytes);
+    if (bytes > 0) {
+      cues_first_ = true;
+    }
+  }
 
-    // Validate track ID exists
-    mkvmuxer::Track* track = segment_->GetTrackByNumber(track_id);
-    if (!track) {
-      throw std::runtime_error("Invalid track ID");
+#ifndef LIBWEBM_JS_NO_PARSER
+  // Copy frames from |parser| into this muxer without leaving WASM. The
+  // output gets one track per selected input track, with the same codec
+  // setup. Options (all optional):
+  //   startNs  - cut point; output starts at the preceding video keyframe
+  //   endNs    - frames at or after this time are dropped
+  //   tracks   - input track numbers to keep, default all audio and video
+  //   offsetNs - timestamp of the cut point in the output, default 0
+  // Returns the number of frames written.
+  uint32_t remux(WebMParser &parser, const emscripten::val &options) {
+    requireNoFrames("remux()");
+    WEBM_STAT(PhaseTimer phase_timer(stats_.mux_ns);)
+
+    const auto number_option = [&options](const char *name, double fallback) {
+      const emscripten::val value = options[name];
+      return value.isUndefined() || value.isNull() ? fallback
+                                                   : value.as<double>();
+    };
+    const long long start_ns =
+        static_cast<long long>(std::max(number_option("startNs", 0), 0.0));
+    const double end_option = number_option("endNs", -1);
+    const long long end_ns = end_option >= 0
+                                 ? static_cast<long long>(end_option)
+                                 : std::numeric_limits<long long>::max();
+    const long long offset_ns =
+        static_cast<long long>(number_option("offsetNs", 0));
+
+    const mkvparser::Tracks *const tracks = parser.tracks();
+    if (!tracks) {
+      throwError("Headers not parsed");
     }
 
-    // Convert emscripten::val (Uint8Array) to std::vector<uint8_t>
-    std::vector<uint8_t> frame_data = emscripten::convertJSArrayToNumberVector<uint8_t>(frame_data_val);
+    std::vector<long> selected;
+    const emscripten::val track_list = options["tracks"];
+    if (track_list.isUndefined() || track_list.isNull()) {
+      for (unsigned long i = 0; i < tracks->GetTracksCount(); ++i) {
+        const mkvparser::Track *const track = tracks->GetTrackByIndex(i);
+        if (track && (track->GetType() == mkvparser::Track::kVideo ||
+                      track->GetType() == mkvparser::Track::kAudio)) {
+          selected.push_back(track->GetNumber());
+        }
+      }
+    } else {
+      const size_t count = track_list["length"].as<size_t>();
+      for (size_t i = 0; i < count; ++i) {
+        selected.push_back(track_list[i].as<long>());
+      }
+    }
 
-    if (frame_data.empty()) {
-      throw std::runtime_error("Frame data is empty");
+    // Create the output tracks; the first video track anchors the cut
+    std::map<long, uint64_t> output_tracks;
+    long anchor_track = -1;
+    for (const long number : selected) {
+      const mkvparser::Track *const track = tracks->GetTrackByNumber(number);
+      if (!track) {
+        throwError("Track not found");
+      }
+      output_tracks[number] = copyTrack(track);
+      if (anchor_track < 0 && track->GetType() == mkvparser::Track::kVideo) {
+        anchor_track = number;
+      }
+    }
+    if (anchor_track < 0 && !selected.empty()) {
+      anchor_track = selected.front();
     }
 
-    bool success = segment_->AddFrame(frame_data.data(), frame_data.size(),
-                                      track_id, timestamp_ns,
-                                      false // Audio frames are not keyframes
-    );
+    long long cut_ns = -1;
+    uint32_t written = 0;
+    parser.visitFrames(
+        selected, anchor_track, start_ns, end_ns,
+        [&](const mkvparser::Track *track,
+            const auto &frame, const uint8_t *data) {
+          if (cut_ns < 0) {
+            // The walk starts on the anchor keyframe (or at the beginning)
+            cut_ns = start_ns > 0 ? frame.timestamp_ns : 0;
+          }
+          if (frame.timestamp_ns < cut_ns || frame.timestamp_ns >= end_ns) {
+            return true;
+          }
+
+          const long long timestamp_ns =
+              frame.timestamp_ns - cut_ns + offset_ns;
+          if (timestamp_ns < 0) {
+            return true;
+          }
 
-    if (!success) {
-      throw std::runtime_error("Failed to write audio frame");
+          frames_written_ = true;
+          if (!segment_->AddFrame(data, static_cast<uint64_t>(frame.len),
+                                  output_tracks[track->GetNumber()],
+                                  static_cast<uint64_t>(timestamp_ns),
+                                  frame.is_keyframe)) {
+            throwError("Failed to write remuxed frame");
+          }
+          ++written;
+          return true;
+        });
+    return written;
+  }
+#endif
+
+  // Return the output produced since the last drain() as a new Uint8Array
+  // and free it from the muxer. Concatenating every drain() result followed
+  // by finalize() yields the complete file.
+  emscripten::val drain() {
+    if (!live_) {
+      throwError("drain() requires live mode");
+    }
+    return writer_->Drain();
+  }
+
+  // Add the first `size` bytes of the staging buffer as a frame
+  void commitFrame(uint32_t track_id, size_t size, uint64_t timestamp_ns,
+                   bool is_keyframe) {
+    if (size > staging_.size()) {
+      throwError("Frame size exceeds the staging buffer");
+    }
+    WEBM_STAT(PhaseTimer phase_timer(stats_.mux_ns);)
+    WEBM_STAT(stats_.bytes_copied_in += size;)
+    if (!addFrame(track_id, size, timestamp_ns, is_keyframe)) {
+      throwError("Failed to write frame");
     }
   }
 
+  // finalize() and getData() return a copy of the output in a new JS
+  // Uint8Array, made chunk by chunk without merging the chunks in WASM
+  // memory first.
   emscripten::val finalize() {
     if (!segment_) {
-      throw std::runtime_error("Segment not initialized");
+      throwError("Segment not initialized");
     }
 
     if (finalized_) {
-      const std::vector<uint8_t>& data = writer_->GetData();
-      return emscripten::val(emscripten::typed_memory_view(data.size(), data.data()));
+      return outputCopy();
     }
 
+    WEBM_STAT(PhaseTimer phase_timer(stats_.finalize_ns);)
     bool success = segment_->Finalize();
     if (!success) {
-      throw std::runtime_error("Failed to finalize segment");
+      throwError("Failed to finalize segment");
+    }
+
+    bool cues_in_reserve = false;
+    if (cues_first_ && segment_->output_cues()) {
+      cues_in_reserve = writeReservedCues();
+      if (!cues_in_reserve) {
+        moveCuesFirst();
+      }
+    }
+    // mkvmuxer pointed the SeekHead's Info entry at the reserve
+    if (!cues_in_reserve && writer_->Layout().cues_reserve >= 0) {
+      std::vector<uint8_t> seek_head;
+      if (!buildSeekHead(-1, seek_head)) {
+        throwError("Failed to update the SeekHead");
+      }
+      writer_->Overwrite(static_cast<size_t>(writer_->Layout().seek_head),
+                         seek_head.data(), seek_head.size());
     }
 
     finalized_ = true;
-    const std::vector<uint8_t>& data = writer_->GetData();
-    return emscripten::val(emscripten::typed_memory_view(data.size(), data.data()));
+    return outputCopy();
   }
 
-  emscripten::val getData() const { 
-    const std::vector<uint8_t>& data = writer_->GetData();
-    return emscripten::val(emscripten::typed_memory_view(data.size(), data.data()));
+  emscripten::val getData() { return outputCopy(); }
+
+  // Counters collected since creation or the last resetStats(), or null
+  // unless the module was built with LIBWEBM_JS_STATS
+  emscripten::val getStats() const {
+#ifdef LIBWEBM_JS_STATS
+    return stats_.toVal();
+#else
+    return emscripten::val::null();
+#endif
   }
 
+  void resetStats() { WEBM_STAT(stats_ = WebMStats();) }
+
 private:
+  void initSegment() {
+    segment_ = std::make_unique<mkvmuxer::Segment>();
+
+    if (!segment_->Init(writer_.get())) {
+      throwError("Failed to initialize muxer segment");
+    }
+
+    segment_->set_mode(mkvmuxer::Segment::kFile);
+    segment_->OutputCues(true);
+
+    // Set up segment info
+    mkvmuxer::SegmentInfo *const info = segment_->GetSegmentInfo();
+    info->set_writing_app("libwebm-js");
+    info->set_muxing_app("libwebm-js");
+  }
+
+  void requireNoFrames(const char *setting) const {
+    if (frames_written_) {
+      throwError(std::string(setting) + " must be set before writing frames");
+    }
+  }
+
+#ifndef LIBWEBM_JS_NO_PARSER
+  // Add an output track with the codec setup of |track|
+  uint64_t copyTrack(const mkvparser::Track *track) {
+    mkvmuxer::Track *output = nullptr;
+    if (track->GetType() == mkvparser::Track::kVideo) {
+      const mkvparser::VideoTrack *const video =
+          static_cast<const mkvparser::VideoTrack *>(track);
+      const uint64_t number = segment_->AddVideoTrack(
+          static_cast<int32_t>(video->GetWidth()),
+          static_cast<int32_t>(video->GetHeight()), 0);
+      mkvmuxer::VideoTrack *const video_output =
+          static_cast<mkvmuxer::VideoTrack *>(
+              segment_->GetTrackByNumber(number));
+      if (video_output) {
+        if (video->GetDisplayWidth() > 0) {
+          video_output->set_display_width(video->GetDisplayWidth());
+        }
+        if (video->GetDisplayHeight() > 0) {
+          video_output->set_display_height(video->GetDisplayHeight());
+        }
+      }
+      output = video_output;
+    } else if (track->GetType() == mkvparser::Track::kAudio) {
+      const mkvparser::AudioTrack *const audio =
+          static_cast<const mkvparser::AudioTrack *>(track);
+      const uint64_t number = segment_->AddAudioTrack(
+          static_cast<int32_t>(audio->GetSamplingRate()),
+          static_cast<int32_t>(audio->GetChannels()), 0);
+      mkvmuxer::AudioTrack *const audio_output =
+          static_cast<mkvmuxer::AudioTrack *>(
+              segment_->GetTrackByNumber(number));
+      if (audio_output) {
+        audio_output->set_sample_rate(audio->GetSamplingRate());
+        if (audio->GetBitDepth() > 0) {
+          audio_output->set_bit_depth(audio->GetBitDepth());
+        }
+      }
+      output = audio_output;
+    } else {
+      throwError("Only audio and video tracks can be remuxed");
+    }
+
+    if (!output) {
+      throwError("Failed to add remux track");
+    }
+
+    output->set_codec_id(track->GetCodecId());
+    size_t codec_private_size = 0;
+    const unsigned char *const codec_private =
+        track->GetCodecPrivate(codec_private_size);
+    if (codec_private && codec_private_size > 0 &&
+        !output->SetCodecPrivate(codec_private, codec_private_size)) {
+      throwError("Failed to copy CodecPrivate");
+    }
+    if (track->GetDefaultDuration() > 0) {
+      output->set_default_duration(track->GetDefaultDuration());
+    }
+    if (track->GetCodecDelay() > 0) {
+      output->set_codec_delay(track->GetCodecDelay());
+    }
+    if (track->GetSeekPreRoll() > 0) {
+      output->set_seek_pre_roll(track->GetSeekPreRoll());
+    }
+    return output->number();
+  }
+#endif
+
+  // Rewrite the finalized file with Cues ahead of the clusters. The old
+  // output is read in place, chunk by chunk, and the copy goes into a
+  // writer reserved for about the same size, so the peak is the two
+  // outputs and nothing more. The copy is swapped into writer_ rather than
+  // replacing it, since segment_ keeps a pointer to the writer.
+  void moveCuesFirst() {
+    const size_t size = writer_->Size();
+    MemoryWriter moved(size + 64 * 1024);
+    WEBM_STAT(moved.SetStats(&stats_);)
+    {
+      WriterReader reader(*writer_);
+      if (!segment_->CopyAndMoveCuesBeforeClusters(&reader, &moved)) {
+        throwError("Failed to move Cues before clusters");
+      }
+    }
+    writer_->Swap(moved);
+  }
+
+  // Segment payload offsets are relative to the end of the Segment ID and
+  // the 8-byte size mkvmuxer always writes for it
+  static constexpr size_t kSegmentHeaderSize = 12;
+
+  // Move the Cues mkvmuxer appended at the end of the file into the
+  // setCuesReserve() Void, padding what is left with a smaller Void, and
+  // cut them off the end. Returns false and changes nothing when there is
+  // no reserve or the Cues do not fit it.
+  bool writeReservedCues() {
+    const MemoryWriter::ElementLayout &layout = writer_->Layout();
+    if (layout.cues_reserve < 0 || layout.cues < 0 || layout.segment < 0) {
+      return false;
+    }
+    const size_t reserve = writer_->CuesReserveSize();
+    const size_t cues_pos = static_cast<size_t>(layout.cues);
+    const size_t cues_size = writer_->Size() - cues_pos;
+    if (cues_size > reserve || reserve - cues_size == 1) {
+      return false;
+    }
+
+    // The Cues must be the last element, or cutting them would lose more
+    uint8_t header[12];
+    const size_t header_len = std::min(sizeof(header), cues_size);
+    uint32_t id = 0;
+    uint64_t size = 0;
+    bool unknown = false;
+    if (!writer_->ReadAt(cues_pos, header_len, header)) {
+      return false;
+    }
+    const int id_len = readId(header, header_len, 0, id);
+    const int size_len =
+        id_len ? readVint(header, header_len, id_len, size, unknown) : 0;
+    if (id != libwebm::kMkvCues || !size_len || unknown ||
+        id_len + size_len + size != cues_size) {
+      return false;
+    }
+
+    const size_t payload_pos =
+        static_cast<size_t>(layout.segment) + kSegmentHeaderSize;
+    std::vector<uint8_t> seek_head;
+    if (!buildSeekHead(
+            layout.cues_reserve - static_cast<int64_t>(payload_pos),
+            seek_head)) {
+      return false;
+    }
+
+    std::vector<uint8_t> cues(cues_size);
+    writer_->ReadAt(cues_pos, cues_size, cues.data());
+    if (reserve > cues_size) {
+      appendEbmlVoid(cues, reserve - cues_size);
+    }
+    writer_->Overwrite(static_cast<size_t>(layout.cues_reserve), cues.data(),
+                       cues.size());
+    writer_->Truncate(cues_pos);
+
+    std::vector<uint8_t> segment_size;
+    appendEbmlSize(segment_size, cues_pos - payload_pos, 8);
+    writer_->Overwrite(payload_pos - 8, segment_size.data(),
+                       segment_size.size());
+    writer_->Overwrite(static_cast<size_t>(layout.seek_head), seek_head.data(),
+                       seek_head.size());
+    return true;
+  }
+
+  // Re-encode the SeekHead written at finalize with its Info entry past
+  // the Cues reserve and, when |cues_offset| is not negative, its Cues
+  // entry at that segment offset. The result is padded with a Void to the
+  // space mkvmuxer reserved for the SeekHead.
+  bool buildSeekHead(int64_t cues_offset, std::vector<uint8_t> &out) const {
+    const MemoryWriter::ElementLayout &layout = writer_->Layout();
+    if (layout.seek_head < 0 || layout.cues_reserve < layout.seek_head ||
+        layout.info < 0 || layout.segment < 0) {
+      return false;
+    }
+    std::vector<uint8_t> old(
+        static_cast<size_t>(layout.cues_reserve - layout.seek_head));
+    if (!writer_->ReadAt(static_cast<size_t>(layout.seek_head), old.size(),
+                         old.data())) {
+      return false;
+    }
+
+    const uint8_t *const data = old.data();
+    size_t pos = 0;
+    uint32_t id = 0;
+    size_t payload = 0;
+    size_t end = 0;
+    if (!readElement(data, old.size(), pos, id, payload, end) ||
+        id != libwebm::kMkvSeekHead) {
+      return false;
+    }
+
+    const int64_t payload_pos = layout.segment + kSegmentHeaderSize;
+    std::vector<uint8_t> entries;
+    for (pos = payload; pos < end;) {
+      size_t seek_payload = 0;
+      size_t seek_next = 0;
+      if (!readElement(data, end, pos, id, seek_payload, seek_next)) {
+        return false;
+      }
+      if (id == libwebm::kMkvSeek) {
+        uint32_t seek_id = 0;
+        uint64_t seek_pos = 0;
+        for (size_t child = seek_payload; child < seek_next;) {
+          uint32_t child_id = 0;
+          size_t child_payload = 0;
+          size_t child_next = 0;
+          if (!readElement(data, seek_next, child, child_id, child_payload,
+                           child_next)) {
+            return false;
+          }
+          if (child_id == libwebm::kMkvSeekID) {
+            seek_id = static_cast<uint32_t>(
+                readUnsigned(data, child_payload, child_next));
+          } else if (child_id == libwebm::kMkvSeekPosition) {
+            seek_pos = readUnsigned(data, child_payload, child_next);
+          }
+          child = child_next;
+        }
+        if (seek_id == libwebm::kMkvInfo) {
+          seek_pos = static_cast<uint64_t>(layout.info - payload_pos);
+        } else if (seek_id == libwebm::kMkvCues && cues_offset >= 0) {
+          seek_pos = static_cast<uint64_t>(cues_offset);
+        }
+
+        std::vector<uint8_t> seek;
+        appendEbmlId(seek, libwebm::kMkvSeekID);
+        appendEbmlSize(seek, ebmlIdLength(seek_id));
+        appendEbmlId(seek, seek_id);
+        appendEbmlUnsigned(seek, libwebm::kMkvSeekPosition, seek_pos);
+        appendEbmlId(entries, libwebm::kMkvSeek);
+        appendEbmlSize(entries, seek.size());
+        entries.insert(entries.end(), seek.begin(), seek.end());
+      }
+      pos = seek_next;
+    }
+
+    out.clear();
+    appendEbmlId(out, libwebm::kMkvSeekHead);
+    appendEbmlSize(out, entries.size());
+    out.insert(out.end(), entries.begin(), entries.end());
+    if (out.size() > old.size() || old.size() - out.size() == 1) {
+      return false;
+    }
+    if (out.size() < old.size()) {
+      appendEbmlVoid(out, old.size() - out.size());
+    }
+    return true;
+  }
+
+  emscripten::val outputCopy() const { return writer_->CopyOut(); }
+
+  // Copy a JS Uint8Array into the staging buffer with a single bulk set()
+  size_t stageFrame(const emscripten::val &frame_data_val) {
+    const size_t size = frame_data_val["length"].as<size_t>();
+    getFrameBuffer(size).call<void>("set", frame_data_val);
+    WEBM_STAT(stats_.bytes_copied_in += size;)
+    return size;
+  }
+
+  bool addFrame(uint32_t track_id, size_t size, uint64_t timestamp_ns,
+                bool is_keyframe) {
+    if (!segment_) {
+      throwError("Segment not initialized");
+    }
+    if (finalized_) {
+      throwError("Muxer has already been finalized");
+    }
+
+    // Validate track ID exists
+    if (!segment_->GetTrackByNumber(track_id)) {
+      throwError("Invalid track ID");
+    }
+    if (size == 0) {
+      throwError("Frame data is empty");
+    }
+
+    frames_written_ = true;
+    WEBM_STAT(++stats_.frames_written;)
+    return segment_->AddFrame(staging_.data(), size, track_id, timestamp_ns,
+                              is_keyframe);
+  }
+
   std::unique_ptr<MemoryWriter> writer_;
   std::unique_ptr<mkvmuxer::Segment> segment_;
+  // Reused across frames so steady-state writes do not allocate
+  std::vector<uint8_t> staging_;
   bool finalized_ = false;
+  bool live_ = false;
+  bool cues_first_ = false;
+  bool frames_written_ = false;
+  WEBM_STAT(WebMStats stats_;)
 };
+#endif
+
+// Whether this module was built with WebAssembly SIMD
+bool simdEnabled() {
+#ifdef __wasm_simd128__
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Whether this module was built with hot-path counters (getStats())
+bool statsEnabled() {
+#ifdef LIBWEBM_JS_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Whether this module was built with worker thread support
+bool threadsEnabled() {
+#ifdef LIBWEBM_JS_THREADS
+  return true;
+#else
+  return false;
+#endif
+}
 
 // Emscripten bindings
 EMSCRIPTEN_BINDINGS(libwebm) {
+  function("threadsEnabled", &threadsEnabled);
+  function("simdEnabled", &simdEnabled);
+  function("statsEnabled", &statsEnabled);
+
   // Error codes
   enum_<WebMErrorCode>("WebMErrorCode")
       .value("SUCCESS", WebMErrorCode::SUCCESS)
@@ -677,13 +4470,24 @@ EMSCRIPTEN_BINDINGS(libwebm) {
   value_object<WebMVideoInfo>("WebMVideoInfo")
       .field("width", &WebMVideoInfo::width)
       .field("height", &WebMVideoInfo::height)
-      .field("frameRate", &WebMVideoInfo::frame_rate);
+      .field("frameRate", &WebMVideoInfo::frame_rate)
+      .field("displayWidth", &WebMVideoInfo::display_width)
+      .field("displayHeight", &WebMVideoInfo::display_height)
+      .field("matrixCoefficients", &WebMVideoInfo::matrix_coefficients)
+      .field("bitsPerChannel", &WebMVideoInfo::bits_per_channel)
+      .field("range", &WebMVideoInfo::range)
+      .field("transferCharacteristics",
+             &WebMVideoInfo::transfer_characteristics)
+      .field("primaries", &WebMVideoInfo::primaries);
 
   value_object<WebMAudioInfo>("WebMAudioInfo")
       .field("samplingFrequency", &WebMAudioInfo::sampling_frequency)
       .field("channels", &WebMAudioInfo::channels)
-      .field("bitDepth", &WebMAudioInfo::bit_depth);
+      .field("bitDepth", &WebMAudioInfo::bit_depth)
+      .field("codecDelayNs", &WebMAudioInfo::codec_delay_ns)
+      .field("seekPreRollNs", &WebMAudioInfo::seek_pre_roll_ns);
 
+#ifndef LIBWEBM_JS_NO_PARSER
   class_<WebMFrameData>("WebMFrameData")
       .function("getData", &WebMFrameData::getData)
       .function("getTimestampNs", &WebMFrameData::getTimestampNs)
@@ -695,26 +4499,80 @@ EMSCRIPTEN_BINDINGS(libwebm) {
       .constructor<const std::string &>()
       .class_function("createFromBuffer", &WebMParser::createFromBuffer,
                       allow_raw_pointers())
+      .class_function("createFromSource", &WebMParser::createFromSource,
+                      allow_raw_pointers())
+      .function("getWriteBuffer", &WebMParser::getWriteBuffer)
+      .function("appendData", &WebMParser::appendData)
+      .function("endOfStream", &WebMParser::endOfStream)
+      .function("isComplete", &WebMParser::isComplete)
+      .function("setLazyLoading", &WebMParser::setLazyLoading)
+      .function("setResilient", &WebMParser::setResilient)
+      .function("getParseErrors", &WebMParser::getParseErrors)
       .function("parseHeaders", &WebMParser::parseHeaders)
       .function("getDuration", &WebMParser::getDuration)
       .function("getTrackCount", &WebMParser::getTrackCount)
       .function("getTrackInfo", &WebMParser::getTrackInfo)
       .function("getVideoInfo", &WebMParser::getVideoInfo)
       .function("getAudioInfo", &WebMParser::getAudioInfo)
+      .function("getCodecPrivate", &WebMParser::getCodecPrivate)
       .function("readNextVideoFrame", &WebMParser::readNextVideoFrame,
                 allow_raw_pointers())
       .function("readNextAudioFrame", &WebMParser::readNextAudioFrame,
-                allow_raw_pointers());
+                allow_raw_pointers())
+      .function("readFrames", &WebMParser::readFrames)
+      .function("readClusterFrames", &WebMParser::readClusterFrames)
+      .function("buildIndex", &WebMParser::buildIndex)
+      .function("buildIndexParallel", &WebMParser::buildIndexParallel)
+      .function("getIndexedFrameCount", &WebMParser::getIndexedFrameCount)
+      .function("exportIndex", &WebMParser::exportIndex)
+      .function("importIndex", &WebMParser::importIndex)
+      .function("seek", &WebMParser::seek)
+      .function("readNextVideoFrameView", &WebMParser::readNextVideoFrameView)
+      .function("readNextAudioFrameView", &WebMParser::readNextAudioFrameView)
+      .function("readNextChunk", &WebMParser::readNextChunk)
+      .function("readNextKeyframe", &WebMParser::readNextKeyframe)
+      .function("getStats", &WebMParser::getStats)
+      .function("resetStats", &WebMParser::resetStats)
+      .function("reset", &WebMParser::reset)
+      .function("rebind", &WebMParser::rebind);
+
+  // Batch header probe
+  class_<WebMProber>("WebMProber")
+      .constructor<>()
+      .function("probe", &WebMProber::probe);
+#endif
 
+#ifndef LIBWEBM_JS_NO_MUXER
   // Muxer class
   class_<WebMMuxer>("WebMMuxer")
       .constructor<>()
+      .constructor<size_t>()
       .function("addVideoTrack", &WebMMuxer::addVideoTrack)
       .function("addAudioTrack", &WebMMuxer::addAudioTrack)
       .function("writeVideoFrame", &WebMMuxer::writeVideoFrame)
       .function("writeAudioFrame", &WebMMuxer::writeAudioFrame)
+      .function("getFrameBuffer", &WebMMuxer::getFrameBuffer)
+      .function("commitFrame", &WebMMuxer::commitFrame)
+      .function("setCodecPrivate", &WebMMuxer::setCodecPrivate)
+      .function("setLiveMode", &WebMMuxer::setLiveMode)
+      .function("drain", &WebMMuxer::drain)
+      .function("setMaxClusterDuration", &WebMMuxer::setMaxClusterDuration)
+      .function("setMaxClusterSize", &WebMMuxer::setMaxClusterSize)
+      .function("setAccurateClusterDuration",
+                &WebMMuxer::setAccurateClusterDuration)
+      .function("setOutputCues", &WebMMuxer::setOutputCues)
+      .function("setCuesTrack", &WebMMuxer::setCuesTrack)
+      .function("setCuesFirst", &WebMMuxer::setCuesFirst)
+      .function("setCuesReserve", &WebMMuxer::setCuesReserve)
+#ifndef LIBWEBM_JS_NO_PARSER
+      .function("remux", &WebMMuxer::remux)
+#endif
       .function("finalize", &WebMMuxer::finalize)
-      .function("getData", &WebMMuxer::getData);
+      .function("getData", &WebMMuxer::getData)
+      .function("getStats", &WebMMuxer::getStats)
+      .function("resetStats", &WebMMuxer::resetStats)
+      .function("reset", &WebMMuxer::reset);
+#endif
 
   // Vector bindings for data transfer
   // Register vector types for Emscripten
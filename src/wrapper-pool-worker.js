@@ -0,0 +1,216 @@
+// BSD 3-Clause License
+
+// Copyright (c) 2025, SCTG Développement
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * Worker side of WebMWorkerPool (wrapper-pool.js). Runs the WASM parser
+ * and muxer from wrapper.js and answers one job at a time. Inputs arrive
+ * as transferred ArrayBuffers or SharedArrayBuffers, and results go back
+ * as transferred buffers, so nothing is structured-cloned.
+ */
+
+import createLibWebM from './wrapper.js';
+
+// Message port of a Web Worker or of a Node.js worker thread
+const IS_WEB_WORKER = typeof WorkerGlobalScope !== 'undefined';
+const port = IS_WEB_WORKER ? self : (await import('node:worker_threads')).parentPort;
+
+function listen(handler) {
+    if (IS_WEB_WORKER) {
+        self.onmessage = (event) => handler(event.data);
+    } else {
+        port.on('message', handler);
+    }
+}
+
+let libwebm = null;
+// Reused for every job with reset(), keeping their WASM memory
+let parser = null;
+let muxer = null;
+
+/**
+ * View the input of a job: { buffer, byteOffset, byteLength }
+ */
+function inputView(input) {
+    return new Uint8Array(input.buffer, input.byteOffset, input.byteLength);
+}
+
+function loadInput(input) {
+    if (!parser) {
+        parser = libwebm.WebMParser.createEmpty();
+    }
+    parser.reset(inputView(input));
+    // The wrapper does not report the status, check it here
+    const status = parser.nativeParser.parseHeaders();
+    if (status.value !== libwebm.WebMErrorCode.SUCCESS) {
+        throw new Error(`Failed to parse headers: error ${status.value}`);
+    }
+}
+
+function describeTracks() {
+    const tracks = [];
+    for (let i = 0; i < parser.getTrackCount(); i++) {
+        tracks.push(parser.getTrackInfo(i));
+    }
+    return tracks;
+}
+
+/**
+ * Read the frames of a track with startNs <= timestamp < endNs into one
+ * buffer, in the layout of readFrames() batches
+ */
+function demuxTrack(trackNumber, startNs, endNs) {
+    if (startNs > 0) {
+        parser.seek(startNs, trackNumber);
+    }
+
+    const chunks = [];
+    const offsets = [];
+    const sizes = [];
+    const timestampsNs = [];
+    const flags = [];
+    let size = 0;
+    for (;;) {
+        const batch = parser.readFrames(trackNumber, 1024);
+        if (batch.count === 0) {
+            break;
+        }
+        let first = -1;
+        let last = -1;
+        let done = false;
+        for (let i = 0; i < batch.count; i++) {
+            const timestampNs = batch.timestampsNs[i];
+            if (timestampNs >= endNs) {
+                done = true;
+                break;
+            }
+            if (timestampNs < startNs) {
+                continue; // Before the range, read from the preceding keyframe
+            }
+            if (first < 0) {
+                first = i;
+            }
+            last = i;
+            offsets.push(size + batch.offsets[i] - batch.offsets[first]);
+            sizes.push(batch.sizes[i]);
+            timestampsNs.push(timestampNs);
+            flags.push(batch.flags[i]);
+        }
+        if (first >= 0) {
+            // The batch views are reused by the next call, copy them out
+            const end = batch.offsets[last] + batch.sizes[last];
+            chunks.push(batch.data.slice(batch.offsets[first], end));
+            size += end - batch.offsets[first];
+        }
+        if (done) {
+            break;
+        }
+    }
+
+    const data = new Uint8Array(size);
+    let position = 0;
+    for (const chunk of chunks) {
+        data.set(chunk, position);
+        position += chunk.length;
+    }
+    return {
+        trackNumber,
+        count: sizes.length,
+        data,
+        offsets: Uint32Array.from(offsets),
+        sizes: Uint32Array.from(sizes),
+        timestampsNs: Float64Array.from(timestampsNs),
+        flags: Uint8Array.from(flags)
+    };
+}
+
+const jobs = {
+    info(job) {
+        loadInput(job.input);
+        return { result: { durationNs: parser.getDuration() * 1e9, tracks: describeTracks() } };
+    },
+
+    demux(job) {
+        loadInput(job.input);
+        const tracks = describeTracks();
+        const wanted = job.tracks || tracks
+            .filter((track) => track.trackType === libwebm.WebMTrackType.VIDEO ||
+                track.trackType === libwebm.WebMTrackType.AUDIO)
+            .map((track) => track.trackNumber);
+        const startNs = job.startNs || 0;
+        const endNs = job.endNs === undefined ? Infinity : job.endNs;
+
+        const frames = wanted.map((trackNumber) => demuxTrack(trackNumber, startNs, endNs));
+        const transfer = [];
+        for (const track of frames) {
+            transfer.push(track.data.buffer, track.offsets.buffer, track.sizes.buffer,
+                track.timestampsNs.buffer, track.flags.buffer);
+        }
+        return {
+            result: { durationNs: parser.getDuration() * 1e9, tracks, frames, startNs, endNs },
+            transfer
+        };
+    },
+
+    remux(job) {
+        loadInput(job.input);
+        if (muxer) {
+            muxer.reset();
+        } else {
+            muxer = libwebm.WebMMuxer();
+        }
+        if (job.cuesFirst) {
+            muxer.setCuesFirst(true);
+        }
+        const frameCount = muxer.remux(parser, job.options || {});
+        const data = muxer.finalize();
+        return { result: { data, frameCount }, transfer: [data.buffer] };
+    }
+};
+
+listen(async (message) => {
+    if (message.type === 'init') {
+        try {
+            libwebm = await createLibWebM(message.options);
+            port.postMessage({ type: 'ready' });
+        } catch (error) {
+            port.postMessage({ type: 'ready', error: error.message || String(error) });
+        }
+        return;
+    }
+
+    try {
+        if (!Object.hasOwn(jobs, message.type)) {
+            throw new Error(`Unknown job type: ${message.type}`);
+        }
+        const { result, transfer = [] } = jobs[message.type](message);
+        port.postMessage({ id: message.id, result }, transfer);
+    } catch (error) {
+        port.postMessage({ id: message.id, error: error.message || String(error) });
+    }
+});
@@ -0,0 +1,296 @@
+// BSD 3-Clause License
+
+// Copyright (c) 2025, SCTG Développement
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * Pool of workers running the WASM parser and muxer, so that demuxing
+ * and remuxing large files does not block the calling thread. Works with
+ * Web Workers and Node.js worker threads.
+ *
+ * Inputs are moved, not copied: an ArrayBuffer (or a Uint8Array over one)
+ * is transferred to the worker running the job and is detached afterwards,
+ * and a SharedArrayBuffer is shared. Results come back transferred.
+ */
+
+/**
+ * Start a worker and wrap the Web Worker and worker_threads interfaces.
+ * Events go to the onMessage and onError handlers of the returned object.
+ */
+async function spawnWorker(url) {
+    const handle = {
+        onMessage: () => {},
+        onError: () => {}
+    };
+
+    if (typeof Worker !== 'undefined') {
+        const worker = new Worker(url, { type: 'module' });
+        worker.onmessage = (event) => handle.onMessage(event.data);
+        worker.onerror = (event) => handle.onError(new Error(event.message));
+        handle.post = (message, transfer) => worker.postMessage(message, transfer);
+        handle.terminate = () => worker.terminate();
+        return handle;
+    }
+
+    const { Worker: NodeWorker } = await import('node:worker_threads');
+    const worker = new NodeWorker(url);
+    worker.on('message', (message) => handle.onMessage(message));
+    worker.on('error', (error) => handle.onError(error));
+    handle.post = (message, transfer) => worker.postMessage(message, transfer);
+    handle.terminate = () => worker.terminate();
+    return handle;
+}
+
+async function defaultWorkerCount() {
+    if (typeof navigator !== 'undefined' && navigator.hardwareConcurrency) {
+        return navigator.hardwareConcurrency;
+    }
+    try {
+        const os = await import('node:os');
+        return os.availableParallelism ? os.availableParallelism() : os.cpus().length;
+    } catch (error) {
+        return 1;
+    }
+}
+
+function isShared(buffer) {
+    return typeof SharedArrayBuffer !== 'undefined' && buffer instanceof SharedArrayBuffer;
+}
+
+/**
+ * Describe an input for postMessage(), listing the buffer to transfer
+ * unless it is shared
+ */
+function packInput(input, transfer) {
+    const view = ArrayBuffer.isView(input)
+        ? input
+        : new Uint8Array(input);
+    if (!isShared(view.buffer)) {
+        transfer.push(view.buffer);
+    }
+    return { buffer: view.buffer, byteOffset: view.byteOffset, byteLength: view.byteLength };
+}
+
+class WebMWorkerPool {
+    constructor(workers) {
+        this.workers = workers;
+        this.idle = [...workers];
+        this.queue = [];
+        this.nextId = 1;
+        for (const worker of workers) {
+            worker.job = null;
+            worker.onMessage = (message) => this.finish(worker, message);
+            worker.onError = (error) => this.fail(worker, error);
+        }
+    }
+
+    /**
+     * Start the workers. Options: workers (count, default one per core),
+     * workerUrl (URL of wrapper-pool-worker.js, when bundled elsewhere)
+     * and moduleOptions (passed to createLibWebM() in each worker).
+     */
+    static async create(options = {}) {
+        const count = options.workers || await defaultWorkerCount();
+        const url = options.workerUrl || new URL('./wrapper-pool-worker.js', import.meta.url);
+
+        const workers = await Promise.all(Array.from({ length: count }, () => spawnWorker(url)));
+        try {
+            await Promise.all(workers.map((worker) => new Promise((resolve, reject) => {
+                worker.onMessage = (message) => {
+                    if (message.error) {
+                        reject(new Error(`Worker failed to load libwebm: ${message.error}`));
+                    } else {
+                        resolve();
+                    }
+                };
+                worker.onError = reject;
+                worker.post({ type: 'init', options: options.moduleOptions || {} }, []);
+            })));
+        } catch (error) {
+            workers.forEach((worker) => worker.terminate());
+            throw error;
+        }
+        return new WebMWorkerPool(workers);
+    }
+
+    /**
+     * Number of workers
+     */
+    get size() {
+        return this.workers.length;
+    }
+
+    /**
+     * Parse the headers of a file: { durationNs, tracks }
+     */
+    info(input) {
+        const transfer = [];
+        return this.run({ type: 'info', input: packInput(input, transfer) }, transfer);
+    }
+
+    /**
+     * Read every frame of a file in one worker. Options: tracks (track
+     * numbers, default every audio and video track), startNs and endNs to
+     * keep only frames with startNs <= timestamp < endNs.
+     * Resolves to { durationNs, tracks, frames }, where frames holds one
+     * entry per track laid out like a readFrames() batch, with its own
+     * buffers: { trackNumber, count, data, offsets, sizes, timestampsNs, flags }.
+     */
+    demux(input, options = {}) {
+        const transfer = [];
+        return this.run({
+            type: 'demux',
+            input: packInput(input, transfer),
+            tracks: options.tracks,
+            startNs: options.startNs,
+            endNs: options.endNs
+        }, transfer);
+    }
+
+    /**
+     * Demux a file split into options.ranges consecutive time ranges (default
+     * one per worker), each read by its own worker from the cluster holding
+     * the keyframe before it. Resolves to the demux() results in time order;
+     * together they hold every frame exactly once. All workers need the
+     * input, so it is copied once into a SharedArrayBuffer unless it already
+     * is one; without SharedArrayBuffer support this is a single demux().
+     */
+    async demuxRanges(input, options = {}) {
+        let view = ArrayBuffer.isView(input) ? input : new Uint8Array(input);
+        if (!isShared(view.buffer)) {
+            if (typeof SharedArrayBuffer === 'undefined') {
+                return [await this.demux(view, options)];
+            }
+            const shared = new Uint8Array(new SharedArrayBuffer(view.byteLength));
+            shared.set(view);
+            view = shared;
+        }
+
+        const ranges = options.ranges || this.size;
+        const { durationNs } = await this.info(view);
+        const jobs = [];
+        for (let i = 0; i < ranges; i++) {
+            jobs.push(this.demux(view, {
+                tracks: options.tracks,
+                startNs: i === 0 ? 0 : Math.floor(durationNs * i / ranges),
+                endNs: i === ranges - 1 ? undefined : Math.floor(durationNs * (i + 1) / ranges)
+            }));
+        }
+        return Promise.all(jobs);
+    }
+
+    /**
+     * Remux a file in a worker, as WebMMuxer.remux() does. Takes the
+     * remux() options plus cuesFirst. Resolves to { data, frameCount }.
+     */
+    remux(input, options = {}) {
+        const transfer = [];
+        const { cuesFirst, ...remuxOptions } = options;
+        return this.run({
+            type: 'remux',
+            input: packInput(input, transfer),
+            options: remuxOptions,
+            cuesFirst: !!cuesFirst
+        }, transfer);
+    }
+
+    /**
+     * Stop the workers. Jobs not finished yet are rejected.
+     */
+    terminate() {
+        const error = new Error('Worker pool terminated');
+        for (const worker of this.workers) {
+            if (worker.job) {
+                worker.job.reject(error);
+                worker.job = null;
+            }
+            worker.terminate();
+        }
+        this.queue.forEach((job) => job.reject(error));
+        this.queue = [];
+        this.workers = [];
+        this.idle = [];
+    }
+
+    run(message, transfer) {
+        if (this.workers.length === 0) {
+            return Promise.reject(new Error('Worker pool has no running workers'));
+        }
+        return new Promise((resolve, reject) => {
+            this.queue.push({ message: { id: this.nextId++, ...message }, transfer, resolve, reject });
+            this.dispatch();
+        });
+    }
+
+    dispatch() {
+        while (this.idle.length > 0 && this.queue.length > 0) {
+            const worker = this.idle.pop();
+            const job = this.queue.shift();
+            worker.job = job;
+            try {
+                worker.post(job.message, job.transfer);
+            } catch (error) {
+                // Not transferable, or already detached by another job
+                worker.job = null;
+                this.idle.push(worker);
+                job.reject(error);
+            }
+        }
+    }
+
+    finish(worker, message) {
+        const job = worker.job;
+        worker.job = null;
+        this.idle.push(worker);
+        if (job) {
+            if (message.error) {
+                job.reject(new Error(message.error));
+            } else {
+                job.resolve(message.result);
+            }
+        }
+        this.dispatch();
+    }
+
+    // A worker died: drop it and fail its job
+    fail(worker, error) {
+        if (worker.job) {
+            worker.job.reject(error);
+            worker.job = null;
+        }
+        this.workers = this.workers.filter((other) => other !== worker);
+        this.idle = this.idle.filter((other) => other !== worker);
+        worker.terminate();
+        if (this.workers.length === 0) {
+            this.queue.forEach((job) => job.reject(error));
+            this.queue = [];
+        }
+    }
+}
+
+export { WebMWorkerPool };
+export default WebMWorkerPool;
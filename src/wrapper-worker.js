@@ -33,6 +33,8 @@
  * where Node.js APIs are not available
  */
 
+import { WebMWorkerPool } from './wrapper-pool.js';
+
 /**
  * WebM Error Codes
  */
@@ -1657,6 +1659,10 @@ async function createLibWebM(options = {}) {
             },
             WebMMuxer: () => new MinimalWebMMuxer(),
 
+            // Runs the full WASM parser and muxer in workers, where the
+            // environment can start them
+            createWorkerPool: (poolOptions) => WebMWorkerPool.create(poolOptions),
+
             // Indicate this is a worker implementation
             _isWorker: true,
             _isFallback: false,
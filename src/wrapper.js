@@ -28,6 +28,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 import Module from '../dist/libwebm.js';
+import { WebMWorkerPool } from './wrapper-pool.js';
 
 /**
  * Detect the runtime environment
@@ -60,6 +61,14 @@ const WebMTrackType = {
     AUDIO: 2
 };
 
+/**
+ * Per-frame flag bits in batches returned by readFrames()
+ */
+const WebMFrameFlags = {
+    KEYFRAME: 1 << 0,
+    INVISIBLE: 1 << 1
+};
+
 /**
  * Utility functions for common operations
  */
@@ -106,6 +115,213 @@ const WebMUtils = {
      */
     getSupportedAudioCodecs() {
         return ['A_OPUS', 'A_VORBIS'];
+    },
+
+    /**
+     * Backpressure for WebMParser.frames() options.ready: returns a function
+     * that resolves once a WebCodecs decoder or encoder holds fewer than
+     * maxQueueSize pending items
+     */
+    whenQueueBelow(codec, maxQueueSize) {
+        const queueSize = () => codec.decodeQueueSize ?? codec.encodeQueueSize;
+        return () => {
+            if (queueSize() < maxQueueSize) {
+                return undefined;
+            }
+            return new Promise((resolve) => {
+                const onDequeue = () => {
+                    if (queueSize() < maxQueueSize) {
+                        codec.removeEventListener('dequeue', onDequeue);
+                        resolve();
+                    }
+                };
+                codec.addEventListener('dequeue', onDequeue);
+            });
+        };
+    }
+};
+
+/**
+ * Matroska Colour values and their WebCodecs VideoColorSpace names
+ */
+const COLOUR_MATRICES = { 0: 'rgb', 1: 'bt709', 5: 'bt470bg', 6: 'smpte170m', 9: 'bt2020-ncl' };
+const COLOUR_TRANSFERS = { 1: 'bt709', 6: 'smpte170m', 8: 'linear', 13: 'iec61966-2-1', 16: 'pq', 18: 'hlg' };
+const COLOUR_PRIMARIES = { 1: 'bt709', 5: 'bt470bg', 6: 'smpte170m', 9: 'bt2020', 12: 'smpte432' };
+
+const hex2 = (value) => value.toString(16).padStart(2, '0');
+const dec2 = (value) => String(value).padStart(2, '0');
+
+/**
+ * WebCodecs codec string of a track, from its codec ID and CodecPrivate,
+ * or null when WebCodecs has no registration for the codec
+ */
+function webCodecsCodec(codecId, codecPrivate, bitDepth) {
+    switch (codecId) {
+        case 'V_VP8':
+            return 'vp8';
+        case 'V_VP9': {
+            // CodecPrivate holds ID/length/value features
+            const features = { 1: 0, 2: 10, 3: bitDepth > 0 ? bitDepth : 8 };
+            for (let i = 0; codecPrivate && i + 2 < codecPrivate.length; i += 2 + codecPrivate[i + 1]) {
+                features[codecPrivate[i]] = codecPrivate[i + 2];
+            }
+            return `vp09.${dec2(features[1])}.${dec2(features[2])}.${dec2(features[3])}`;
+        }
+        case 'V_AV01': {
+            // av1C: marker/version, profile and level, tier and bit depth
+            if (!codecPrivate || codecPrivate.length < 4) {
+                return `av01.0.08M.${dec2(bitDepth > 0 ? bitDepth : 8)}`;
+            }
+            const profile = codecPrivate[1] >> 5;
+            const level = codecPrivate[1] & 0x1f;
+            const tier = codecPrivate[2] & 0x80 ? 'H' : 'M';
+            const depth = codecPrivate[2] & 0x40 ? (codecPrivate[2] & 0x20 ? 12 : 10) : 8;
+            return `av01.${profile}.${dec2(level)}${tier}.${dec2(depth)}`;
+        }
+        case 'V_MPEG4/ISO/AVC':
+            // avcC: profile, constraint flags and level follow the version
+            return codecPrivate && codecPrivate.length >= 4
+                ? `avc1.${hex2(codecPrivate[1])}${hex2(codecPrivate[2])}${hex2(codecPrivate[3])}`
+                : null;
+        case 'A_OPUS':
+            return 'opus';
+        case 'A_VORBIS':
+            return 'vorbis';
+        case 'A_FLAC':
+            return 'flac';
+        case 'A_MPEG/L3':
+            return 'mp3';
+        default:
+            if (codecId.startsWith('A_AAC')) {
+                // AudioSpecificConfig starts with the object type
+                return `mp4a.40.${codecPrivate && codecPrivate.length > 0 ? codecPrivate[0] >> 3 : 2}`;
+            }
+            return null;
+    }
+}
+
+/**
+ * Codec ID of a WebCodecs codec string
+ */
+function codecIdFromWebCodecs(codec) {
+    const prefixes = [
+        ['vp8', 'V_VP8'], ['vp09', 'V_VP9'], ['av01', 'V_AV01'], ['avc1', 'V_MPEG4/ISO/AVC'],
+        ['opus', 'A_OPUS'], ['vorbis', 'A_VORBIS'], ['flac', 'A_FLAC'], ['mp3', 'A_MPEG/L3'], ['mp4a', 'A_AAC']
+    ];
+    const match = prefixes.find(([prefix]) => codec === prefix || codec.startsWith(`${prefix}.`));
+    if (!match) {
+        throw new Error(`Codec ${codec} cannot be written to WebM`);
+    }
+    return match[1];
+}
+
+/**
+ * OpusHead for an encoder config without a description: mapping family 0
+ * (mono or stereo), no pre-skip, no gain
+ */
+function opusHead(channels, sampleRate) {
+    const head = new Uint8Array(19);
+    const view = new DataView(head.buffer);
+    head.set([0x4f, 0x70, 0x75, 0x73, 0x48, 0x65, 0x61, 0x64]); // "OpusHead"
+    head[8] = 1;
+    head[9] = channels;
+    view.setUint32(12, sampleRate, true);
+    return head;
+}
+
+/**
+ * Copy of a WebCodecs description (BufferSource) as a Uint8Array
+ */
+function descriptionBytes(description) {
+    return ArrayBuffer.isView(description)
+        ? new Uint8Array(description.buffer, description.byteOffset, description.byteLength)
+        : new Uint8Array(description);
+}
+
+/**
+ * Let the event loop run pending tasks (rendering, input, I/O) before
+ * continuing. Faster than setTimeout(0), which browsers clamp.
+ */
+function yieldToEventLoop() {
+    if (typeof setImmediate === 'function') {
+        return new Promise((resolve) => setImmediate(resolve));
+    }
+    if (typeof MessageChannel === 'function') {
+        return new Promise((resolve) => {
+            const channel = new MessageChannel();
+            channel.port1.onmessage = () => {
+                channel.port1.close();
+                resolve();
+            };
+            channel.port2.postMessage(null);
+        });
+    }
+    return new Promise((resolve) => setTimeout(resolve, 0));
+}
+
+/**
+ * Random-access inputs for WebMParser.createFromSource(). A source is an
+ * object { size, readInto(position, target) } whose readInto() fills the
+ * Uint8Array target synchronously and returns the number of bytes written.
+ */
+const WebMSources = {
+    /**
+     * Read from an open Node.js file descriptor
+     */
+    fromFileDescriptor(fs, fd) {
+        return {
+            size: fs.fstatSync(fd).size,
+            readInto(position, target) {
+                return fs.readSync(fd, target, 0, target.length, position);
+            }
+        };
+    },
+
+    /**
+     * Read from a Blob or File. FileReaderSync is only available in workers.
+     */
+    fromBlob(blob) {
+        const reader = new FileReaderSync();
+        return {
+            size: blob.size,
+            readInto(position, target) {
+                const bytes = reader.readAsArrayBuffer(blob.slice(position, position + target.length));
+                target.set(new Uint8Array(bytes));
+                return bytes.byteLength;
+            }
+        };
+    },
+
+    /**
+     * Read a remote file with HTTP range requests. Synchronous XHR with a
+     * binary response is only allowed in workers. The size is fetched with
+     * a HEAD request unless given.
+     */
+    fromUrl(url, size) {
+        if (size === undefined) {
+            const head = new XMLHttpRequest();
+            head.open('HEAD', url, false);
+            head.send();
+            size = Number(head.getResponseHeader('Content-Length'));
+            if (head.status !== 200 || !Number.isFinite(size)) {
+                throw new Error(`Cannot get the size of ${url}: HTTP ${head.status}`);
+            }
+        }
+        return {
+            size,
+            readInto(position, target) {
+                const request = new XMLHttpRequest();
+                request.open('GET', url, false);
+                request.responseType = 'arraybuffer';
+                request.setRequestHeader('Range', `bytes=${position}-${position + target.length - 1}`);
+                request.send();
+                if (request.status !== 206) {
+                    return -1;
+                }
+                target.set(new Uint8Array(request.response));
+                return request.response.byteLength;
+            }
+        };
     }
 };
 
@@ -116,6 +332,9 @@ class WebMParser {
     constructor(module, nativeParser) {
         this.module = module;
         this.nativeParser = nativeParser;
+        this.streaming = false;
+        // Resolved by the next appendData() or endOfStream()
+        this.dataWaiters = [];
     }
 
     /**
@@ -129,11 +348,112 @@ class WebMParser {
         // Convert buffer to Uint8Array if it's not already
         const uint8Buffer = buffer instanceof Uint8Array ? buffer : new Uint8Array(buffer);
 
-        // Pass buffer directly to C++ (emscripten::val handles the conversion)
+        // Pass buffer directly to C++, which copies it into the WASM heap in one go
         const nativeParser = module.WebMParser.createFromBuffer(uint8Buffer);
         return new WebMParser(module, nativeParser);
     }
 
+    /**
+     * Create a parser reading on demand from a source (see WebMSources),
+     * through a cache of options.cacheBlocks blocks of options.blockSize
+     * bytes. Frame views stay valid only until the next read.
+     */
+    static createFromSource(module, source, options = {}) {
+        const nativeParser = module.WebMParser.createFromSource(
+            source, options.blockSize || 0, options.cacheBlocks || 0);
+        return new WebMParser(module, nativeParser);
+    }
+
+    /**
+     * Create a parser with no input, to be filled through getWriteBuffer()
+     */
+    static createEmpty(module) {
+        return new WebMParser(module, new module.WebMParser());
+    }
+
+    /**
+     * Create a streaming parser fed chunk by chunk through appendData()
+     */
+    static createStreaming(module) {
+        const parser = new WebMParser(module, new module.WebMParser());
+        parser.streaming = true;
+        return parser;
+    }
+
+    /**
+     * Append a chunk of a streamed file. Headers and clusters are parsed
+     * as soon as their bytes have arrived, so frames can be read before the
+     * download completes. Frame views returned earlier may be invalidated.
+     * Consumed clusters are released only once every audio and video track
+     * has been read from; a readNextKeyframe() started later skips, and
+     * reports, the keyframes already released.
+     */
+    appendData(chunk) {
+        const uint8Chunk = chunk instanceof Uint8Array ? chunk : new Uint8Array(chunk);
+        this.streaming = true;
+        const status = this.nativeParser.appendData(uint8Chunk);
+        this.wakeDataWaiters();
+        if (status !== undefined && status.value !== WebMErrorCode.SUCCESS) {
+            throw new Error(`Failed to parse streamed data: error ${status.value}`);
+        }
+    }
+
+    /**
+     * Signal that no more chunks will be appended
+     */
+    endOfStream() {
+        const status = this.nativeParser.endOfStream();
+        this.wakeDataWaiters();
+        if (status !== undefined && status.value !== WebMErrorCode.SUCCESS) {
+            throw new Error(`Failed to finish stream: error ${status.value}`);
+        }
+    }
+
+    /**
+     * Whether the whole stream has been received. When a read returns null
+     * and this is false, more data is needed before further frames appear.
+     */
+    isComplete() {
+        return this.nativeParser.isComplete();
+    }
+
+    /**
+     * Get a view over a parser-owned input buffer of the given size.
+     * Write the file bytes into it before calling parseHeaders(). The view
+     * is detached if the WASM memory grows, so fill it right away.
+     */
+    getWriteBuffer(size) {
+        if (!Number.isInteger(size) || size <= 0) {
+            throw new Error('Write buffer size must be a positive integer');
+        }
+        return this.nativeParser.getWriteBuffer(size);
+    }
+
+    /**
+     * Only parse headers and Cues in parseHeaders(), loading clusters on
+     * demand as frames are read or sought. Must be called before parsing.
+     */
+    setLazyLoading(enabled) {
+        this.nativeParser.setLazyLoading(enabled);
+    }
+
+    /**
+     * Keep going on damaged files: corrupt regions are skipped up to the
+     * next cluster and reported by getParseErrors() instead of failing the
+     * parse. Must be called before parsing.
+     */
+    setResilient(enabled) {
+        this.nativeParser.setResilient(enabled);
+    }
+
+    /**
+     * Problems met while parsing and reading, as { position, code } where
+     * position is a byte offset and code a WebMErrorCode value
+     */
+    getParseErrors() {
+        return this.nativeParser.getParseErrors();
+    }
+
     /**
      * Parse the WebM file headers
      */
@@ -194,7 +514,16 @@ class WebMParser {
         return {
             width: info.width,
             height: info.height,
-            frameRate: info.frameRate
+            frameRate: info.frameRate,
+            displayWidth: info.displayWidth,
+            displayHeight: info.displayHeight,
+            colour: {
+                matrixCoefficients: info.matrixCoefficients,
+                bitsPerChannel: info.bitsPerChannel,
+                range: info.range,
+                transferCharacteristics: info.transferCharacteristics,
+                primaries: info.primaries
+            }
         };
     }
 
@@ -209,12 +538,135 @@ class WebMParser {
         return {
             samplingFrequency: info.samplingFrequency,
             channels: info.channels,
-            bitDepth: info.bitDepth
+            bitDepth: info.bitDepth,
+            codecDelayNs: info.codecDelayNs,
+            seekPreRollNs: info.seekPreRollNs
         };
     }
 
     /**
-     * Read the next video frame from the WebM file
+     * Get the CodecPrivate bytes of a track, or null if it has none.
+     * The view points into parser memory: valid while the parser is alive
+     * and until the WASM memory grows.
+     */
+    getCodecPrivate(trackNumber) {
+        return this.nativeParser.getCodecPrivate(trackNumber);
+    }
+
+    /**
+     * VideoDecoderConfig or AudioDecoderConfig for a track: codec string,
+     * dimensions or sample rate and channels, and the CodecPrivate as
+     * description for the codecs whose WebCodecs registration takes one.
+     * Returns null when WebCodecs cannot decode the codec.
+     */
+    getDecoderConfig(trackNumber) {
+        let trackInfo = null;
+        for (let i = 0; i < this.getTrackCount() && !trackInfo; i++) {
+            const info = this.getTrackInfo(i);
+            if (info.trackNumber === trackNumber) {
+                trackInfo = info;
+            }
+        }
+        if (!trackInfo) {
+            throw new Error(`Track ${trackNumber} not found`);
+        }
+
+        const codecPrivate = this.getCodecPrivate(trackNumber);
+        if (trackInfo.trackType === WebMTrackType.VIDEO) {
+            const video = this.getVideoInfo(trackNumber);
+            const codec = webCodecsCodec(trackInfo.codecId, codecPrivate, video.colour.bitsPerChannel);
+            if (!codec) {
+                return null;
+            }
+            const config = {
+                codec,
+                codedWidth: video.width,
+                codedHeight: video.height,
+                displayAspectWidth: video.displayWidth,
+                displayAspectHeight: video.displayHeight
+            };
+            // VP8 and VP9 CodecPrivate is not a decoder description
+            if (codecPrivate && (codec.startsWith('av01') || codec.startsWith('avc1'))) {
+                config.description = codecPrivate.slice();
+            }
+            const colorSpace = {};
+            const { matrixCoefficients, transferCharacteristics, primaries, range } = video.colour;
+            if (COLOUR_MATRICES[matrixCoefficients]) colorSpace.matrix = COLOUR_MATRICES[matrixCoefficients];
+            if (COLOUR_TRANSFERS[transferCharacteristics]) colorSpace.transfer = COLOUR_TRANSFERS[transferCharacteristics];
+            if (COLOUR_PRIMARIES[primaries]) colorSpace.primaries = COLOUR_PRIMARIES[primaries];
+            if (range === 1 || range === 2) colorSpace.fullRange = range === 2;
+            if (Object.keys(colorSpace).length > 0) {
+                config.colorSpace = colorSpace;
+            }
+            return config;
+        }
+
+        if (trackInfo.trackType === WebMTrackType.AUDIO) {
+            const audio = this.getAudioInfo(trackNumber);
+            const codec = webCodecsCodec(trackInfo.codecId, codecPrivate, audio.bitDepth);
+            if (!codec) {
+                return null;
+            }
+            const config = {
+                codec,
+                sampleRate: audio.samplingFrequency,
+                numberOfChannels: audio.channels
+            };
+            if (codecPrivate && codec !== 'mp3') {
+                config.description = codecPrivate.slice();
+            }
+            return config;
+        }
+        return null;
+    }
+
+    /**
+     * Read the next frame of a track as an EncodedVideoChunkInit or
+     * EncodedAudioChunkInit, e.g. new EncodedVideoChunk(parser.readNextChunk(1)).
+     * data is a view as in readNextVideoFrameView() (a copy for file- and
+     * source-backed parsers), copied by the chunk constructor. Returns null
+     * at the end of the track.
+     */
+    readNextChunk(trackNumber) {
+        return this.nativeParser.readNextChunk(trackNumber);
+    }
+
+    /**
+     * Async iterator over a track's frames as chunk init objects, with the
+     * batching, backpressure and streaming behaviour of frames(). Give it
+     * ready: WebMUtils.whenQueueBelow(decoder, n) to pace it by the decoder.
+     * Each chunk's data views the batch buffer, which is reused: it is
+     * valid until the next batch is read, whatever the input.
+     */
+    async *chunks(options = {}) {
+        if (!Number.isInteger(options.track)) {
+            throw new Error('chunks() needs a track number');
+        }
+        let isAudio = null;
+        for await (const batch of this.frames(options)) {
+            if (isAudio === null) {
+                const info = Array.from({ length: this.getTrackCount() }, (_, i) => this.getTrackInfo(i))
+                    .find((track) => track.trackNumber === options.track);
+                if (!info) {
+                    throw new Error(`Track ${options.track} not found`);
+                }
+                isAudio = info.trackType === WebMTrackType.AUDIO;
+            }
+            for (let i = 0; i < batch.count; i++) {
+                const offset = batch.offsets[i];
+                yield {
+                    type: isAudio || (batch.flags[i] & WebMFrameFlags.KEYFRAME) ? 'key' : 'delta',
+                    timestamp: Math.trunc(batch.timestampsNs[i] / 1000),
+                    data: batch.data.subarray(offset, offset + batch.sizes[i])
+                };
+            }
+        }
+    }
+
+    /**
+     * Read the next video frame from the WebM file. Call release() once
+     * done with data to recycle its buffer for the next frames; data must
+     * not be used afterwards.
      */
     readNextVideoFrame(trackId) {
         const frame = this.nativeParser.readNextVideoFrame(trackId);
@@ -224,12 +676,14 @@ class WebMParser {
         return {
             data: frame.getData(),
             timestampNs: frame.getTimestampNs(),
-            isKeyframe: frame.getIsKeyframe()
+            isKeyframe: frame.getIsKeyframe(),
+            release: () => frame.delete()
         };
     }
 
     /**
-     * Read the next audio frame from the WebM file
+     * Read the next audio frame from the WebM file. Same release() contract
+     * as readNextVideoFrame().
      */
     readNextAudioFrame(trackId) {
         const frame = this.nativeParser.readNextAudioFrame(trackId);
@@ -239,18 +693,239 @@ class WebMParser {
         return {
             data: frame.getData(),
             timestampNs: frame.getTimestampNs(),
-            isKeyframe: false
+            isKeyframe: false,
+            release: () => frame.delete()
         };
     }
+
+    /**
+     * Read up to maxFrames frames of a track in a single call.
+     * Returns { count, data, offsets, sizes, timestampsNs, flags }: frame i
+     * is data.subarray(offsets[i], offsets[i] + sizes[i]). The views are
+     * reused by the next readFrames() call on this parser. Frames that
+     * cannot be read are left out and reported by getParseErrors().
+     */
+    readFrames(trackNumber, maxFrames = 256) {
+        return this.nativeParser.readFrames(trackNumber, maxFrames);
+    }
+
+    /**
+     * Like readFrames(), but a batch never spans two clusters
+     */
+    readClusterFrames(trackNumber, maxFrames = 256) {
+        return this.nativeParser.readClusterFrames(trackNumber, maxFrames);
+    }
+
+    /**
+     * Iterate over the frames of a track with for await...of, one batch per
+     * cluster (split further by batchSize). Reads happen only when the
+     * consumer asks for the next batch; options.ready, when given, is called
+     * before each read and may return a promise to hold reading back, e.g.
+     * WebMUtils.whenQueueBelow(decoder, 16). After sliceMs of reading the
+     * iterator yields to the event loop. On a streaming parser it waits for
+     * appendData() until the stream is complete.
+     * Batches are readFrames() views, valid until the next iteration.
+     */
+    async *frames(options = {}) {
+        const { track, batchSize = 256, ready, sliceMs = 8 } = options;
+        if (!Number.isInteger(track)) {
+            throw new Error('frames() needs a track number');
+        }
+
+        // Headers of a stream arrive with its first chunks
+        while (this.streaming && !this.headersParsed()) {
+            if (this.isComplete()) {
+                throw new Error('Stream ended before its headers');
+            }
+            await this.waitForData();
+        }
+
+        let sliceStart = performance.now();
+        for (;;) {
+            if (ready) {
+                await ready();
+            }
+            const batch = this.nativeParser.readClusterFrames(track, batchSize);
+            if (batch.count === 0) {
+                if (!this.streaming || this.isComplete()) {
+                    return;
+                }
+                await this.waitForData();
+                sliceStart = performance.now();
+                continue;
+            }
+            yield batch;
+
+            if (performance.now() - sliceStart >= sliceMs) {
+                await yieldToEventLoop();
+                sliceStart = performance.now();
+            }
+        }
+    }
+
+    headersParsed() {
+        // Streaming parsers only report whether appendData() parsed them
+        const status = this.nativeParser.parseHeaders();
+        return status !== undefined && status.value === WebMErrorCode.SUCCESS;
+    }
+
+    waitForData() {
+        return new Promise((resolve) => this.dataWaiters.push(resolve));
+    }
+
+    wakeDataWaiters() {
+        const waiters = this.dataWaiters;
+        this.dataWaiters = [];
+        waiters.forEach((resolve) => resolve());
+    }
+
+    /**
+     * Index every track in a single pass over the file. Reads and seeks on
+     * indexed tracks then skip other tracks' blocks entirely.
+     */
+    buildIndex() {
+        const status = this.nativeParser.buildIndex();
+        if (status !== undefined && status.value !== WebMErrorCode.SUCCESS) {
+            throw new Error(`Failed to build frame index: error ${status.value}`);
+        }
+    }
+
+    /**
+     * Build the same index as buildIndex() by scanning clusters directly
+     * from the input, spread over worker threads in the threaded build
+     * (createLibWebM({ threads: true })). threadCount 0 uses one per core;
+     * either way no more than the module's thread pool (4 workers by
+     * default, plus the calling thread).
+     */
+    buildIndexParallel(threadCount = 0) {
+        const status = this.nativeParser.buildIndexParallel(threadCount);
+        if (status !== undefined && status.value !== WebMErrorCode.SUCCESS) {
+            throw new Error(`Failed to build frame index: error ${status.value}`);
+        }
+    }
+
+    /**
+     * Serialize the frame index built by buildIndex() into a small blob
+     * to store next to the file (IndexedDB, R2...). It is tied to this
+     * input by its size and a checksum.
+     */
+    exportIndex() {
+        return this.nativeParser.exportIndex();
+    }
+
+    /**
+     * Load an index from exportIndex() instead of scanning the file. With
+     * lazy loading, opening then reads no cluster until frames are read.
+     */
+    importIndex(blob) {
+        const status = this.nativeParser.importIndex(blob instanceof Uint8Array ? blob : new Uint8Array(blob));
+        if (status.value === WebMErrorCode.INVALID_FILE) {
+            throw new Error('Frame index was made for another file');
+        }
+        if (status.value !== WebMErrorCode.SUCCESS) {
+            throw new Error(`Failed to load frame index: error ${status.value}`);
+        }
+    }
+
+    /**
+     * Number of frames indexed for a track by buildIndex()
+     */
+    getIndexedFrameCount(trackNumber) {
+        return this.nativeParser.getIndexedFrameCount(trackNumber);
+    }
+
+    /**
+     * Move the reader of a track to the keyframe at or before a timestamp.
+     * The next read on that track returns the keyframe.
+     */
+    seek(timestampNs, trackNumber) {
+        const status = this.nativeParser.seek(timestampNs, trackNumber);
+        if (status !== undefined && status.value !== WebMErrorCode.SUCCESS) {
+            throw new Error(`Failed to seek to ${timestampNs}ns on track ${trackNumber}: error ${status.value}`);
+        }
+    }
+
+    /**
+     * Read the next video frame without copying its payload.
+     * `data` views the parser input buffer: it is only valid while the
+     * parser is alive and until the WASM memory grows. File- and
+     * source-backed parsers have no such buffer and return a copy.
+     */
+    readNextVideoFrameView(trackId) {
+        return this.nativeParser.readNextVideoFrameView(trackId);
+    }
+
+    /**
+     * Read the next audio frame without copying its payload.
+     * Same lifetime rules as readNextVideoFrameView().
+     */
+    readNextAudioFrameView(trackId) {
+        return this.nativeParser.readNextAudioFrameView(trackId);
+    }
+
+    /**
+     * Read the next keyframe of a video track, skipping delta frames
+     * without touching their payload. Independent of the regular frame
+     * readers. Same lifetime rules as readNextVideoFrameView().
+     */
+    readNextKeyframe(trackId) {
+        return this.nativeParser.readNextKeyframe(trackId);
+    }
+
+    /**
+     * Hot-path counters since creation or the last resetStats(), or null
+     * unless the module was built with LIBWEBM_JS_STATS
+     */
+    getStats() {
+        return this.nativeParser.getStats();
+    }
+
+    resetStats() {
+        this.nativeParser.resetStats();
+    }
+
+    /**
+     * Start over on another file with the memory already allocated by this
+     * parser. Pass the new file, or nothing to fill it through
+     * getWriteBuffer() or appendData(). Views from the previous file become
+     * invalid.
+     */
+    reset(buffer = null) {
+        const uint8Buffer = buffer === null || buffer instanceof Uint8Array
+            ? buffer
+            : new Uint8Array(buffer);
+        this.nativeParser.reset(uint8Buffer);
+        this.streaming = false;
+    }
+
+    /**
+     * Like reset(), reading the new file from a source as with
+     * createFromSource()
+     */
+    rebind(source, options = {}) {
+        this.nativeParser.rebind(
+            source, options.blockSize || 0, options.cacheBlocks || 0);
+        this.streaming = false;
+    }
 }
 
 /**
  * WebM Muxer wrapper
  */
 class WebMMuxer {
-    constructor(module) {
+    /**
+     * options.expectedSize: estimated output size in bytes. When given, the
+     * output buffer is reserved once up front instead of grown in chunks.
+     * options.live: write a live stream, see setLiveMode().
+     */
+    constructor(module, options = {}) {
         this.module = module;
-        this.nativeMuxer = new module.WebMMuxer();
+        this.nativeMuxer = options.expectedSize > 0
+            ? new module.WebMMuxer(options.expectedSize)
+            : new module.WebMMuxer();
+        if (options.live) {
+            this.nativeMuxer.setLiveMode(true);
+        }
     }
 
     /**
@@ -300,22 +975,224 @@ class WebMMuxer {
     }
 
     /**
-     * Finalize the WebM file and get the data
+     * Get a view over the muxer-owned staging buffer for a frame of the
+     * given size. Write the encoded frame into it, then call commitFrame().
+     * The view is detached if the WASM memory grows, so fill it right away.
+     */
+    getFrameBuffer(size) {
+        if (!Number.isInteger(size) || size <= 0) {
+            throw new Error('Frame buffer size must be a positive integer');
+        }
+        return this.nativeMuxer.getFrameBuffer(size);
+    }
+
+    /**
+     * Write the first `size` bytes of the staging buffer as a frame
+     */
+    commitFrame(trackId, size, timestampNs, isKeyframe) {
+        try {
+            this.nativeMuxer.commitFrame(trackId, size, timestampNs, isKeyframe);
+        } catch (error) {
+            throw new Error(`Failed to commit frame: ${error.message || error}`);
+        }
+    }
+
+    /**
+     * Add a track described by a WebCodecs config, normally the
+     * metadata.decoderConfig passed to a VideoEncoder or AudioEncoder
+     * output callback. Its description becomes the CodecPrivate; Opus
+     * tracks without one get a default OpusHead. Returns the track ID.
+     */
+    addTrackFromConfig(config) {
+        const codecId = codecIdFromWebCodecs(config.codec);
+        const isVideo = codecId.startsWith('V_');
+        const trackId = isVideo
+            ? this.addVideoTrack(config.codedWidth, config.codedHeight, codecId)
+            : this.addAudioTrack(config.sampleRate, config.numberOfChannels, codecId);
+
+        let codecPrivate = config.description ? descriptionBytes(config.description) : null;
+        if (!codecPrivate && codecId === 'A_OPUS') {
+            codecPrivate = opusHead(config.numberOfChannels, config.sampleRate);
+        }
+        if (codecPrivate && codecPrivate.length > 0) {
+            this.setCodecPrivate(trackId, codecPrivate);
+        }
+        return trackId;
+    }
+
+    /**
+     * Set the CodecPrivate of a track before the first frame is written
+     */
+    setCodecPrivate(trackId, data) {
+        this.nativeMuxer.setCodecPrivate(trackId, data instanceof Uint8Array ? data : new Uint8Array(data));
+    }
+
+    /**
+     * Write an EncodedVideoChunk or EncodedAudioChunk. copyTo() writes the
+     * payload straight into the staging buffer, so it is copied only once
+     * more, into the output. Timestamps are in microseconds, as in WebCodecs.
+     */
+    writeChunk(trackId, chunk) {
+        chunk.copyTo(this.getFrameBuffer(chunk.byteLength));
+        this.commitFrame(trackId, chunk.byteLength, chunk.timestamp * 1000, chunk.type === 'key');
+    }
+
+    /**
+     * Write a live (streamable) file: no Cues, unknown element sizes and
+     * append-only output that can be collected with drain(). Must be
+     * called before the first frame is written.
+     */
+    setLiveMode(enabled) {
+        this.nativeMuxer.setLiveMode(enabled);
+    }
+
+    /**
+     * Start a new cluster once the current one spans this many nanoseconds
+     * (0 = no limit). Cluster and cue settings must be set before the first
+     * frame is written.
+     */
+    setMaxClusterDuration(durationNs) {
+        this.nativeMuxer.setMaxClusterDuration(durationNs);
+    }
+
+    /**
+     * Start a new cluster once the current one holds this many bytes
+     * (0 = no limit)
+     */
+    setMaxClusterSize(sizeBytes) {
+        this.nativeMuxer.setMaxClusterSize(sizeBytes);
+    }
+
+    /**
+     * Write exact cluster durations, at the cost of buffering one frame
+     */
+    setAccurateClusterDuration(enabled) {
+        this.nativeMuxer.setAccurateClusterDuration(enabled);
+    }
+
+    /**
+     * Whether to write Cues (on by default outside live mode)
+     */
+    setOutputCues(enabled) {
+        this.nativeMuxer.setOutputCues(enabled);
+    }
+
+    /**
+     * Only add cue points for this track (defaults to the first video track)
+     */
+    setCuesTrack(trackId) {
+        this.nativeMuxer.setCuesTrack(trackId);
+    }
+
+    /**
+     * Place Cues before the clusters so the file can be seeked without
+     * reading to the end. Unless setCuesReserve() left room for them,
+     * finalize() then copies the whole output once more, an O(output)
+     * rewrite with about twice the output size in memory at its peak.
+     */
+    setCuesFirst(enabled) {
+        this.nativeMuxer.setCuesFirst(enabled);
+    }
+
+    /**
+     * Reserve space for the Cues near the start of the file and place them
+     * first. Cues that fit are written there in place at finalize(); larger
+     * ones fall back to the setCuesFirst() rewrite. Allow about 12 to 20
+     * bytes per cue point. Call before writing frames; 0 removes it.
+     */
+    setCuesReserve(bytes) {
+        this.nativeMuxer.setCuesReserve(bytes);
+    }
+
+    /**
+     * Copy frames from a parser into this muxer inside WASM, without
+     * passing them through JS. Creates the output tracks itself, so call
+     * it on a fresh muxer. Options: startNs (cut at the preceding video
+     * keyframe), endNs, tracks (input track numbers) and offsetNs.
+     * Returns the number of frames written.
+     */
+    remux(parser, options = {}) {
+        try {
+            return this.nativeMuxer.remux(parser.nativeParser, options);
+        } catch (error) {
+            throw new Error(`Failed to remux: ${error.message || error}`);
+        }
+    }
+
+    /**
+     * Live mode only: return the bytes produced since the last call and
+     * release them from the muxer. The drained chunks followed by the
+     * finalize() result form the complete file.
+     */
+    drain() {
+        return this.nativeMuxer.drain();
+    }
+
+    /**
+     * Hot-path counters since creation or the last resetStats(), or null
+     * unless the module was built with LIBWEBM_JS_STATS
+     */
+    getStats() {
+        return this.nativeMuxer.getStats();
+    }
+
+    resetStats() {
+        this.nativeMuxer.resetStats();
+    }
+
+    /**
+     * Start a new file with no tracks, reusing the output memory of the
+     * previous one. Takes the same options.live as the constructor.
+     */
+    reset(options = {}) {
+        this.nativeMuxer.reset();
+        if (options.live) {
+            this.nativeMuxer.setLiveMode(true);
+        }
+    }
+
+    /**
+     * Finalize the WebM file and get the data. In live mode this is only
+     * the output not yet returned by drain().
      */
     finalize() {
         const data = this.nativeMuxer.finalize();
         if (!data) {
             throw new Error('Failed to finalize WebM data');
         }
-        return new Uint8Array(data);
+        // Already a JS-owned copy, made one output chunk at a time
+        return data;
     }
 
     /**
      * Get the current WebM data (before finalization)
      */
     getData() {
-        const data = this.nativeMuxer.getData();
-        return new Uint8Array(data);
+        return this.nativeMuxer.getData();
+    }
+}
+
+/**
+ * Batch metadata probe wrapper. One prober reuses its scratch memory
+ * across batches.
+ */
+class WebMProber {
+    constructor(module) {
+        this.module = module;
+        this.nativeProber = new module.WebMProber();
+    }
+
+    /**
+     * Probe many inputs at once, reading only their headers. Each input is
+     * a Uint8Array holding a file, or { data, size } where data is the
+     * start of a file of size bytes (a few KB are normally enough). In the
+     * threaded build inputs are probed on options.threadCount workers,
+     * 0 meaning one per core, capped by the module's thread pool.
+     * Returns per input { status, truncated, durationNs, cuesPosition, tracks };
+     * truncated means more leading bytes are needed.
+     */
+    probe(inputs, options = {}) {
+        return this.nativeProber.probe(inputs, options.threadCount || 0);
     }
 }
 
@@ -331,19 +1208,44 @@ class WebMFile {
     /**
      * Load WebM file from buffer
      */
-    static async fromBuffer(buffer, module) {
+    static async fromBuffer(buffer, module, options = {}) {
         const file = new WebMFile();
         file.parser = WebMParser.createFromBuffer(module, buffer);
+        if (options.lazy) {
+            file.parser.setLazyLoading(true);
+        }
+        if (options.resilient) {
+            file.parser.setResilient(true);
+        }
+        file.parser.parseHeaders();
+        if (options.index) {
+            file.parser.importIndex(options.index);
+        }
+        return file;
+    }
+
+    /**
+     * Load WebM file from a random-access source (see WebMSources)
+     */
+    static async fromSource(source, module, options = {}) {
+        const file = new WebMFile();
+        file.parser = WebMParser.createFromSource(module, source, options);
+        if (options.lazy) {
+            file.parser.setLazyLoading(true);
+        }
         file.parser.parseHeaders();
+        if (options.index) {
+            file.parser.importIndex(options.index);
+        }
         return file;
     }
 
     /**
      * Create new WebM file for writing
      */
-    static forWriting(module) {
+    static forWriting(module, options = {}) {
         const file = new WebMFile();
-        file.muxer = new WebMMuxer(module);
+        file.muxer = new WebMMuxer(module, options);
         return file;
     }
 
@@ -412,6 +1314,118 @@ class WebMFile {
     }
 }
 
+// Minimal module using a v128 instruction, from wasm-feature-detect
+const SIMD_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10,
+    1, 8, 0, 65, 0, 253, 15, 253, 98, 11
+]);
+
+function isSimdSupported() {
+    try {
+        return typeof WebAssembly === 'object' && WebAssembly.validate(SIMD_PROBE);
+    } catch (error) {
+        return false;
+    }
+}
+
+// Optional variants are resolved at runtime next to the baseline module,
+// so bundling an app against a dist/ with only libwebm.js still works.
+// Bundled apps that ship a variant pass its factory as `moduleFactory`.
+function importVariant(name) {
+    const url = new URL('../dist/' + name + '.js', import.meta.url).href;
+    return import(/* webpackIgnore: true */ /* @vite-ignore */ url);
+}
+
+/**
+ * Pick the module variant to load. The threaded build needs
+ * SharedArrayBuffer (cross-origin isolation in browsers) and is only used
+ * on request; the SIMD build is used whenever the runtime supports it
+ * unless `simd` is false. `size` prefers the -Oz build (libwebm-size) and
+ * `parts` ('parser' or 'muxer') a module with only that half of the
+ * library; both apply to the single-threaded build. Variants that were
+ * not built, or cannot be imported by URL (bundles, Cloudflare Workers),
+ * fall back to the baseline module.
+ */
+async function loadModuleFactory({ threads = false, simd = true, size = false, parts } = {}) {
+    if (parts !== undefined && parts !== 'parser' && parts !== 'muxer') {
+        throw new Error(`Unknown module parts "${parts}", expected "parser" or "muxer"`);
+    }
+    const names = [];
+    if (threads) {
+        if (simd && isSimdSupported()) names.push('libwebm-mt-simd');
+        names.push('libwebm-mt');
+    } else {
+        const useSimd = simd && isSimdSupported();
+        if (size && parts) names.push(`libwebm-size-${parts}`);
+        if (size) names.push('libwebm-size');
+        if (useSimd && parts) names.push(`libwebm-simd-${parts}`);
+        if (parts) names.push(`libwebm-${parts}`);
+        if (useSimd) names.push('libwebm-simd');
+    }
+
+    for (const name of names) {
+        try {
+            return (await importVariant(name)).default;
+        } catch (error) {
+            // Variant not built, try the next one
+        }
+    }
+    if (threads) {
+        throw new Error('The multi-threaded build (libwebm-mt) is not available');
+    }
+    return Module;
+}
+
+// Compiled modules by URL, so later instances skip compilation
+const compiledModules = new Map();
+
+async function compileStreaming(response) {
+    response = await response;
+    if (typeof WebAssembly.compileStreaming === 'function') {
+        try {
+            return await WebAssembly.compileStreaming(response.clone());
+        } catch (error) {
+            // Wrong MIME type or no streaming support, compile from bytes
+        }
+    }
+    return WebAssembly.compile(await response.arrayBuffer());
+}
+
+/**
+ * Emscripten instantiateWasm hook for the `wasmModule`, `wasmUrl` and
+ * `wasmResponse` options, or null to let the module fetch its own .wasm.
+ * A precompiled `wasmModule` (e.g. a Cloudflare Workers .wasm import) is
+ * instantiated directly; a URL or Response is compiled while it downloads.
+ * The .wasm must belong to the module variant being loaded. Failures are
+ * reported through `onError`, since Emscripten does not reject on them.
+ */
+function wasmInstantiator({ wasmModule, wasmUrl, wasmResponse }, onCompiled, onError) {
+    if (!wasmModule && !wasmUrl && !wasmResponse) return null;
+
+    const compiled = async () => {
+        if (wasmModule) return wasmModule;
+        if (wasmResponse) return compileStreaming(wasmResponse);
+        const url = String(wasmUrl);
+        if (!compiledModules.has(url)) {
+            const pending = compileStreaming(fetch(url));
+            compiledModules.set(url, pending);
+            pending.catch(() => compiledModules.delete(url));
+        }
+        return compiledModules.get(url);
+    };
+
+    return (imports, receiveInstance) => {
+        compiled()
+            .then(async (module) => {
+                const instance = await WebAssembly.instantiate(module, imports);
+                onCompiled(module);
+                receiveInstance(instance, module);
+            })
+            .catch(onError);
+        return {};
+    };
+}
+
 /**
  * Main factory function
  */
@@ -433,17 +1447,61 @@ async function createLibWebM(options = {}) {
             };
         }
 
-        const module = await Module(moduleOptions);
+        const {
+            threads, simd, size, parts, moduleFactory, wasmModule, wasmUrl, wasmResponse,
+            ...factoryOptions
+        } = moduleOptions;
+        const factory = moduleFactory || await loadModuleFactory({ threads, simd, size, parts });
+
+        let compiledModule = wasmModule || null;
+        let instantiateFailed;
+        const failure = new Promise((resolve, reject) => { instantiateFailed = reject; });
+        const instantiateWasm = wasmInstantiator(
+            { wasmModule, wasmUrl, wasmResponse },
+            (compiled) => { compiledModule = compiled; },
+            instantiateFailed
+        );
+        if (instantiateWasm) factoryOptions.instantiateWasm = instantiateWasm;
+        const module = await Promise.race([factory(factoryOptions), failure]);
+
+        // Split modules only bind one half of the library
+        const requireClass = (name) => {
+            if (!module[name]) {
+                throw new Error(`${name} is not available in this module (loaded with parts: '${parts}')`);
+            }
+        };
 
         return {
             WebMErrorCode,
             WebMTrackType,
+            WebMFrameFlags,
             WebMUtils,
+            WebMSources,
             WebMParser: {
-                createFromBuffer: (buffer) => WebMParser.createFromBuffer(module, buffer)
+                createFromBuffer: (buffer) => (requireClass('WebMParser'), WebMParser.createFromBuffer(module, buffer)),
+                createFromSource: (source, options) => (requireClass('WebMParser'), WebMParser.createFromSource(module, source, options)),
+                createEmpty: () => (requireClass('WebMParser'), WebMParser.createEmpty(module)),
+                createStreaming: () => (requireClass('WebMParser'), WebMParser.createStreaming(module))
             },
-            WebMMuxer: (options) => new WebMMuxer(module),
+            WebMMuxer: (options) => (requireClass('WebMMuxer'), new WebMMuxer(module, options)),
+            WebMProber: () => (requireClass('WebMProber'), new WebMProber(module)),
             WebMFile,
+            // Same module variant in every worker unless poolOptions say
+            // otherwise. Workers both parse and mux, so `parts` is not passed.
+            createWorkerPool: (poolOptions = {}) => WebMWorkerPool.create({
+                moduleOptions: { threads, simd, size },
+                ...poolOptions
+            }),
+            threadsEnabled: module.threadsEnabled(),
+            simdEnabled: module.simdEnabled(),
+            statsEnabled: module.statsEnabled(),
+            hasParser: Boolean(module.WebMParser),
+            hasMuxer: Boolean(module.WebMMuxer),
+
+            // Compiled WebAssembly.Module when instantiated from wasmModule,
+            // wasmUrl or wasmResponse; pass it as wasmModule to start more
+            // instances (or workers) without compiling again
+            wasmModule: compiledModule,
 
             // Direct access to the native module if needed
             _module: module
@@ -71,15 +71,38 @@ class LibWebMTests {
 
             // Parser tests
             await this.testParseValidWebMFile();
+            await this.testParseFromWriteBuffer();
             await this.testGetWebMDuration();
             await this.testGetWebMTrackCount();
             await this.testGetWebMTrackInfo();
+            await this.testGetWebMCodecMetadata();
             await this.testWebMFileStructureValidation();
             await this.testWebMCodecValidation();
 
             // Frame extraction tests
             await this.testWebMFrameExtraction();
             await this.testWebMFrameExtractionWithTiming();
+            await this.testWebMFrameCursorAdvances();
+            await this.testWebMFrameViewsMatchCopies();
+            await this.testWebMStreamingParser();
+            await this.testWebMSeek();
+            await this.testWebMLazyLoading();
+            await this.testWebMBatchedFrameReads();
+            await this.testWebMTrackIndex();
+            await this.testWebMParallelIndex();
+            await this.testWebMSourceReader();
+            await this.testWebMStats();
+            await this.testWebMFramePool();
+            await this.testWebMBatchProbe();
+            await this.testWebMParserReset();
+            await this.testWebMWorkerPool();
+            await this.testWebMFrameIterator();
+            await this.testWebMCodecsBridge();
+            await this.testWebMIndexBlob();
+            await this.testWebMModuleVariants();
+            await this.testWebMAudioFrameTiming();
+            await this.testWebMKeyframeReader();
+            await this.testWebMResilientParsing();
 
             // Muxer tests
             await this.testWebMMuxerCreation();
@@ -88,6 +111,11 @@ class LibWebMTests {
             await this.testWebMMuxerMixedTracks();
             await this.testWebMMuxerTimestampOrdering();
             await this.testWebMMuxerErrorHandling();
+            await this.testWebMMuxerStagedFrames();
+            await this.testWebMMuxerLargeOutput();
+            await this.testWebMMuxerLiveDrain();
+            await this.testWebMMuxerClusterAndCueSettings();
+            await this.testWebMRemux();
 
             // Round trip tests
             await this.testWebMRoundTrip();
@@ -219,6 +247,21 @@ class LibWebMTests {
         console.log('✓ Valid WebM file parsing test passed');
     }
 
+    async testParseFromWriteBuffer() {
+        console.log('Testing parse from parser-owned write buffer...');
+
+        const buffer = fs.readFileSync(this.sampleWebMPath);
+        const parser = this.libwebm.WebMParser.createEmpty();
+        parser.getWriteBuffer(buffer.length).set(buffer);
+        parser.parseHeaders();
+
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        assert.strictEqual(parser.getTrackCount(), reference.getTrackCount());
+        assert.strictEqual(parser.getDuration(), reference.getDuration());
+
+        console.log('✓ Write buffer parsing test passed');
+    }
+
     async testGetWebMDuration() {
         console.log('Testing get WebM duration...');
 
@@ -296,6 +339,35 @@ class LibWebMTests {
         console.log('✓ Track info test passed');
     }
 
+    async testGetWebMCodecMetadata() {
+        console.log('Testing WebM codec metadata...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+
+        for (let i = 0; i < file.getTrackCount(); i++) {
+            const trackInfo = file.getTrackInfo(i);
+            if (trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO) {
+                const videoInfo = file.parser.getVideoInfo(trackInfo.trackNumber);
+                assert.ok(videoInfo.displayWidth > 0 && videoInfo.displayHeight > 0, 'Display size should be set');
+                assert.strictEqual(typeof videoInfo.colour.primaries, 'number');
+                assert.throws(() => file.parser.getAudioInfo(trackInfo.trackNumber), 'Video track has no audio info');
+            } else if (trackInfo.trackType === this.libwebm.WebMTrackType.AUDIO) {
+                const audioInfo = file.parser.getAudioInfo(trackInfo.trackNumber);
+                assert.ok(audioInfo.bitDepth >= 0);
+                if (trackInfo.codecId === 'A_OPUS') {
+                    // OpusHead is mandatory CodecPrivate for Opus in WebM
+                    const codecPrivate = file.parser.getCodecPrivate(trackInfo.trackNumber);
+                    assert.ok(codecPrivate && codecPrivate.length >= 19, 'Opus track should carry OpusHead');
+                    assert.strictEqual(String.fromCharCode(...codecPrivate.subarray(0, 8)), 'OpusHead');
+                    assert.strictEqual(codecPrivate[9], audioInfo.channels, 'OpusHead channel count should match');
+                }
+            }
+        }
+
+        console.log('✓ Codec metadata test passed');
+    }
+
     async testWebMFileStructureValidation() {
         console.log('Testing WebM file structure validation...');
 
@@ -495,6 +567,1065 @@ class LibWebMTests {
         console.log('✓ Frame extraction with timing test passed');
     }
 
+    async testWebMFrameCursorAdvances() {
+        console.log('Testing WebM frame cursor advances...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+
+        let videoTrackNumber = 0;
+        for (let i = 0; i < file.getTrackCount(); i++) {
+            const trackInfo = file.getTrackInfo(i);
+            if (trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO) {
+                videoTrackNumber = trackInfo.trackNumber;
+                break;
+            }
+        }
+
+        // Successive reads must walk forward through the file and stop at the end
+        let frames = 0;
+        let lastTimestampNs = -1;
+        let frameData;
+        while ((frameData = file.parser.readNextVideoFrame(videoTrackNumber)) !== null) {
+            assert.ok(frameData.timestampNs >= lastTimestampNs, 'Video timestamps should not go backwards');
+            lastTimestampNs = frameData.timestampNs;
+            frames++;
+            assert.ok(frames < 1000000, 'Frame cursor should reach end of stream');
+        }
+
+        assert.ok(frames > 1, 'Should read more than one distinct video frame');
+        assert.ok(lastTimestampNs > 0, 'Cursor should move past the first frame');
+        assert.strictEqual(file.parser.readNextVideoFrame(videoTrackNumber), null, 'Cursor should stay at end of stream');
+
+        console.log(`Read ${frames} video frames in one pass`);
+        console.log('✓ Frame cursor test passed');
+    }
+
+    async testWebMFrameViewsMatchCopies() {
+        console.log('Testing zero-copy frame views...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const copied = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const viewed = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const trackNumber = copied.getTrackInfo(0).trackNumber;
+
+        for (let i = 0; i < 5; i++) {
+            const frame = copied.parser.readNextVideoFrame(trackNumber);
+            const view = viewed.parser.readNextVideoFrameView(trackNumber);
+            if (!frame) {
+                assert.strictEqual(view, null, 'Views should end with the copying reader');
+                break;
+            }
+            assert.ok(view, 'View should be returned while frames remain');
+            assert.strictEqual(Number(view.timestampNs), Number(frame.timestampNs));
+            assert.strictEqual(view.isKeyframe, frame.isKeyframe);
+            assert.deepStrictEqual(new Uint8Array(view.data), new Uint8Array(frame.data));
+        }
+
+        console.log('✓ Zero-copy frame view test passed');
+    }
+
+    async testWebMStreamingParser() {
+        console.log('Testing streaming WebM parser...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const trackNumber = reference.getTrackInfo(0).trackNumber;
+
+        let expectedFrames = 0;
+        while (reference.parser.readNextVideoFrame(trackNumber)) {
+            expectedFrames++;
+        }
+
+        // Feed small chunks and drain frames as soon as they become available
+        const parser = this.libwebm.WebMParser.createStreaming();
+        const chunkSize = 4096;
+        let streamedFrames = 0;
+        for (let offset = 0; offset < buffer.length; offset += chunkSize) {
+            parser.appendData(buffer.subarray(offset, offset + chunkSize));
+            if (offset + chunkSize < buffer.length) {
+                assert.strictEqual(parser.isComplete(), false, 'Stream should not be complete before the last chunk');
+            }
+            while (parser.readNextVideoFrame(trackNumber)) {
+                streamedFrames++;
+            }
+        }
+        const framesBeforeEnd = streamedFrames;
+        parser.endOfStream();
+        assert.strictEqual(parser.isComplete(), true);
+        while (parser.readNextVideoFrame(trackNumber)) {
+            streamedFrames++;
+        }
+
+        assert.strictEqual(streamedFrames, expectedFrames, 'Streaming should yield every frame');
+        if (buffer.length > 2 * chunkSize) {
+            assert.ok(framesBeforeEnd > 0, 'Frames should be readable before the stream ends');
+        }
+
+        // Draining one track while the stream arrives must not release
+        // the clusters another track has not been read from yet
+        let expectedAudio = 0;
+        const audioTrack = reference.getTrackInfo(1).trackNumber;
+        while (reference.parser.readNextAudioFrame(audioTrack)) {
+            expectedAudio++;
+        }
+        const sequential = this.libwebm.WebMParser.createStreaming();
+        let sequentialVideo = 0;
+        for (let offset = 0; offset < buffer.length; offset += chunkSize) {
+            sequential.appendData(buffer.subarray(offset, offset + chunkSize));
+            while (sequential.readNextVideoFrame(trackNumber)) {
+                sequentialVideo++;
+            }
+        }
+        sequential.endOfStream();
+        while (sequential.readNextVideoFrame(trackNumber)) {
+            sequentialVideo++;
+        }
+        let sequentialAudio = 0;
+        while (sequential.readNextAudioFrame(audioTrack)) {
+            sequentialAudio++;
+        }
+        assert.strictEqual(sequentialVideo, expectedFrames, 'The first track should yield every frame');
+        assert.strictEqual(sequentialAudio, expectedAudio, 'A track read afterwards should yield every frame');
+
+        console.log(`Streamed ${streamedFrames} video frames (${framesBeforeEnd} before end of stream)`);
+        console.log('✓ Streaming parser test passed');
+    }
+
+    async testWebMSeek() {
+        console.log('Testing WebM seek...');
+
+        const buffer = fs.readFileSync(this.sampleWebMPath);
+        const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const trackNumber = file.getTrackInfo(0).trackNumber;
+
+        const frames = [];
+        let frame;
+        while ((frame = file.parser.readNextVideoFrame(trackNumber)) !== null) {
+            frames.push({ timestampNs: Number(frame.timestampNs), isKeyframe: frame.isKeyframe });
+        }
+        assert.ok(frames.length > 0, 'Should read video frames');
+
+        // Seeking to the middle lands on the closest preceding keyframe
+        const targetNs = frames[Math.floor(frames.length / 2)].timestampNs;
+        file.parser.seek(targetNs, trackNumber);
+        const landed = file.parser.readNextVideoFrame(trackNumber);
+        assert.ok(landed, 'Should read a frame after seeking');
+        assert.ok(landed.isKeyframe, 'Seek should land on a keyframe');
+        assert.ok(Number(landed.timestampNs) <= targetNs, 'Keyframe should not be after the target');
+
+        // Seeking back to the start restarts the track
+        file.parser.seek(0, trackNumber);
+        assert.strictEqual(Number(file.parser.readNextVideoFrame(trackNumber).timestampNs), frames[0].timestampNs);
+
+        // Reads through the fallback id (0, not a track number) share the
+        // cursor that a seek by track number moves
+        const aliased = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        assert.strictEqual(Number(aliased.parser.readNextVideoFrame(0).timestampNs), frames[0].timestampNs);
+        aliased.parser.seek(targetNs, trackNumber);
+        assert.strictEqual(Number(aliased.parser.readNextVideoFrame(0).timestampNs), Number(landed.timestampNs),
+            'Seek by track number should move the fallback reader');
+        aliased.parser.seek(0, trackNumber);
+        assert.strictEqual(Number(aliased.parser.readNextVideoFrame(0).timestampNs), frames[0].timestampNs);
+
+        console.log('✓ Seek test passed');
+    }
+
+    async testWebMLazyLoading() {
+        console.log('Testing lazy WebM cluster loading...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const eager = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const lazy = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module, { lazy: true });
+
+        // Header metadata is available without loading clusters
+        assert.strictEqual(lazy.getDuration(), eager.getDuration());
+        assert.strictEqual(lazy.getTrackCount(), eager.getTrackCount());
+
+        // Clusters load on demand and yield the same frames
+        const trackNumber = eager.getTrackInfo(0).trackNumber;
+        let eagerFrames = 0;
+        let lazyFrames = 0;
+        while (eager.parser.readNextVideoFrame(trackNumber)) eagerFrames++;
+        while (lazy.parser.readNextVideoFrame(trackNumber)) lazyFrames++;
+        assert.strictEqual(lazyFrames, eagerFrames, 'Lazy loading should yield every frame');
+
+        console.log('✓ Lazy loading test passed');
+    }
+
+    async testWebMBatchedFrameReads() {
+        console.log('Testing batched WebM frame reads...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const single = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const batched = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const trackInfo = single.getTrackInfo(0);
+        const read = trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO
+            ? (parser) => parser.readNextVideoFrame(trackInfo.trackNumber)
+            : (parser) => parser.readNextAudioFrame(trackInfo.trackNumber);
+
+        let total = 0;
+        for (;;) {
+            const batch = batched.parser.readFrames(trackInfo.trackNumber, 16);
+            assert.ok(batch.count <= 16, 'Batch should respect maxFrames');
+            if (batch.count === 0) break;
+
+            for (let i = 0; i < batch.count; i++) {
+                const expected = read(single.parser);
+                assert.ok(expected, 'Batch should not return more frames than single reads');
+                const data = batch.data.subarray(batch.offsets[i], batch.offsets[i] + batch.sizes[i]);
+                assert.deepStrictEqual(new Uint8Array(data), new Uint8Array(expected.data));
+                assert.strictEqual(batch.timestampsNs[i], Number(expected.timestampNs));
+                if (trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO) {
+                    assert.strictEqual(Boolean(batch.flags[i] & this.libwebm.WebMFrameFlags.KEYFRAME), expected.isKeyframe);
+                }
+            }
+            total += batch.count;
+        }
+
+        assert.ok(total > 0, 'Should read frames in batches');
+        assert.strictEqual(read(single.parser), null, 'Batches should cover every frame');
+
+        console.log(`Read ${total} frames in batches`);
+        console.log('✓ Batched frame read test passed');
+    }
+
+    async testWebMTrackIndex() {
+        console.log('Testing per-track WebM frame index...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const scanned = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const indexed = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        indexed.parser.buildIndex();
+
+        for (let i = 0; i < scanned.getTrackCount(); i++) {
+            const trackInfo = scanned.getTrackInfo(i);
+            let read;
+            if (trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO) {
+                read = (parser) => parser.readNextVideoFrame(trackInfo.trackNumber);
+            } else if (trackInfo.trackType === this.libwebm.WebMTrackType.AUDIO) {
+                read = (parser) => parser.readNextAudioFrame(trackInfo.trackNumber);
+            } else {
+                continue;
+            }
+
+            // Indexed reads must return the same frames as block scans
+            let frames = 0;
+            let expected;
+            while ((expected = read(scanned.parser)) !== null) {
+                const actual = read(indexed.parser);
+                assert.ok(actual, 'Indexed reader should not end early');
+                assert.strictEqual(Number(actual.timestampNs), Number(expected.timestampNs));
+                assert.strictEqual(actual.data.length, expected.data.length);
+                frames++;
+            }
+            assert.strictEqual(read(indexed.parser), null, 'Indexed reader should end with the scan');
+            assert.strictEqual(indexed.parser.getIndexedFrameCount(trackInfo.trackNumber), frames);
+        }
+
+        console.log('✓ Track index test passed');
+    }
+
+    async testWebMParallelIndex() {
+        console.log('Testing parallel WebM frame index...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        for (const options of [{}, { lazy: true }]) {
+            const sequential = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+            sequential.parser.buildIndex();
+            const parallel = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module, options);
+            parallel.parser.buildIndexParallel(4);
+
+            for (let i = 0; i < sequential.getTrackCount(); i++) {
+                const trackNumber = sequential.getTrackInfo(i).trackNumber;
+                const count = sequential.parser.getIndexedFrameCount(trackNumber);
+                assert.strictEqual(parallel.parser.getIndexedFrameCount(trackNumber), count,
+                    'Cluster scan should index the same frames as mkvparser');
+
+                // Compare the frame tables and payloads; copy the first batch
+                // since the second readFrames() call reuses its storage
+                const expected = sequential.parser.readFrames(trackNumber, count);
+                const expectedData = Uint8Array.from(expected.data);
+                const expectedTimestamps = Array.from(expected.timestampsNs);
+                const expectedFlags = Array.from(expected.flags);
+                const actual = parallel.parser.readFrames(trackNumber, count);
+                assert.strictEqual(actual.count, expected.count);
+                assert.deepStrictEqual(Array.from(actual.timestampsNs), expectedTimestamps);
+                assert.deepStrictEqual(Array.from(actual.flags), expectedFlags);
+                assert.ok(Buffer.from(actual.data).equals(Buffer.from(expectedData)), 'Payloads should match');
+            }
+        }
+
+        console.log('✓ Parallel index test passed');
+    }
+
+    async testWebMSourceReader() {
+        console.log('Testing WebM parsing from a random-access source...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const expected = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const fd = fs.openSync(this.av1OpusWebMPath, 'r');
+        try {
+            // Small blocks so that frames straddle cache blocks and get evicted
+            const source = this.libwebm.WebMSources.fromFileDescriptor(fs, fd);
+            const file = await this.libwebm.WebMFile.fromSource(source, this.libwebm._module,
+                { blockSize: 4096, cacheBlocks: 4 });
+
+            assert.strictEqual(file.getTrackCount(), expected.getTrackCount());
+            assert.strictEqual(file.getDuration(), expected.getDuration());
+            for (let i = 0; i < file.getTrackCount(); i++) {
+                const trackInfo = file.getTrackInfo(i);
+                const isVideo = trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO;
+                const read = (parser) => isVideo
+                    ? parser.readNextVideoFrame(trackInfo.trackNumber)
+                    : parser.readNextAudioFrame(trackInfo.trackNumber);
+
+                let frames = 0;
+                let frame;
+                while ((frame = read(file.parser)) !== null) {
+                    const reference = read(expected.parser);
+                    assert.ok(reference, 'Source parser should not return extra frames');
+                    assert.strictEqual(frame.timestampNs, reference.timestampNs);
+                    assert.ok(Buffer.from(frame.data).equals(Buffer.from(reference.data)),
+                        'Frame payloads should match the buffer parser');
+                    frames++;
+                }
+                assert.strictEqual(read(expected.parser), null, 'Source parser should return every frame');
+                assert.ok(frames > 0, 'Should read frames from the source');
+            }
+
+            // Views out of the block cache must survive later reads
+            const viewed = await this.libwebm.WebMFile.fromSource(
+                this.libwebm.WebMSources.fromFileDescriptor(fs, fd), this.libwebm._module,
+                { blockSize: 4096, cacheBlocks: 1 });
+            const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+            const views = [];
+            let view;
+            while ((view = viewed.parser.readNextVideoFrameView(1)) !== null) {
+                views.push(view.data);
+            }
+            assert.ok(views.length > 1, 'Should read several frame views');
+            for (const data of views) {
+                const expectedView = reference.parser.readNextVideoFrameView(1);
+                assert.ok(Buffer.from(data).equals(Buffer.from(expectedView.data)),
+                    'Earlier source-backed views should keep their bytes');
+            }
+        } finally {
+            fs.closeSync(fd);
+        }
+
+        // A source that stops delivering never yields stale pooled bytes:
+        // the read fails and is reported instead
+        let failing = false;
+        const flaky = {
+            size: buffer.length,
+            readInto(position, target) {
+                if (failing) {
+                    return 0;
+                }
+                target.set(buffer.subarray(position, position + target.length));
+                return Math.min(target.length, buffer.length - position);
+            }
+        };
+        const flakyFile = await this.libwebm.WebMFile.fromSource(flaky, this.libwebm._module,
+            { blockSize: 4096, cacheBlocks: 2 });
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const videoTrack = flakyFile.getTrackInfo(0).trackType === this.libwebm.WebMTrackType.VIDEO
+            ? flakyFile.getTrackInfo(0).trackNumber : flakyFile.getTrackInfo(1).trackNumber;
+        assert.ok(flakyFile.parser.readNextVideoFrame(videoTrack));
+        reference.parser.readNextVideoFrame(videoTrack);
+        failing = true;
+        let failure = null;
+        try {
+            let frame;
+            while ((frame = flakyFile.parser.readNextVideoFrame(videoTrack)) !== null) {
+                const expectedFrame = reference.parser.readNextVideoFrame(videoTrack);
+                assert.ok(Buffer.from(frame.data).equals(Buffer.from(expectedFrame.data)),
+                    'Frames returned by a failing source should hold their own bytes');
+            }
+        } catch (error) {
+            failure = error;
+        }
+        assert.ok(failure ? /Failed to read frame data/.test(failure.message)
+            : flakyFile.parser.getParseErrors().length > 0, 'The failed read should be reported');
+
+        // Batches skip and record frames the source fails to deliver, like
+        // frames whose bytes are missing, instead of discarding the batch
+        failing = false;
+        const flakyBatches = await this.libwebm.WebMFile.fromSource(flaky, this.libwebm._module,
+            { blockSize: 4096, cacheBlocks: 2 });
+        assert.ok(flakyBatches.parser.readFrames(videoTrack, 1).count === 1);
+        failing = true;
+        const batch = flakyBatches.parser.readFrames(videoTrack, 256);
+        const fullBatch = (await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module)).parser;
+        fullBatch.readFrames(videoTrack, 1);
+        assert.ok(batch.count < fullBatch.readFrames(videoTrack, 256).count, 'Undeliverable frames should be left out');
+        assert.ok(flakyBatches.parser.getParseErrors().length > 0, 'The failed reads should be recorded');
+
+        console.log('✓ Source reader test passed');
+    }
+
+    async testWebMStats() {
+        console.log('Testing WebM hot-path stats...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const muxer = this.libwebm.WebMMuxer();
+
+        if (!this.libwebm.statsEnabled) {
+            // Release builds compile the counters out
+            assert.strictEqual(file.parser.getStats(), null);
+            assert.strictEqual(muxer.getStats(), null);
+            console.log('✓ Stats test passed (counters compiled out)');
+            return;
+        }
+
+        const trackInfo = file.getTrackInfo(0);
+        const isVideo = trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO;
+        let frames = 0;
+        while ((isVideo ? file.parser.readNextVideoFrame(trackInfo.trackNumber)
+            : file.parser.readNextAudioFrame(trackInfo.trackNumber)) !== null) {
+            frames++;
+        }
+
+        const stats = file.parser.getStats();
+        assert.strictEqual(stats.bytesCopiedIn, buffer.length, 'Input copy should be counted');
+        assert.strictEqual(stats.framesReturned, frames);
+        assert.ok(stats.blocksVisited >= frames / 16, 'Blocks visited should be counted');
+        assert.ok(stats.reads > 0 && stats.bytesRead > 0, 'Reader traffic should be counted');
+        assert.ok(stats.clustersLoaded > 0);
+        assert.ok(stats.phases.parseNs > 0 && stats.phases.readNs > 0);
+        file.parser.resetStats();
+        assert.strictEqual(file.parser.getStats().framesReturned, 0);
+
+        const videoTrack = muxer.addVideoTrack(320, 240, 'V_VP8');
+        for (let i = 0; i < 10; i++) {
+            muxer.writeVideoFrame(videoTrack, new Uint8Array(1000), i * 33333333, i === 0);
+        }
+        const output = muxer.finalize();
+        const muxStats = muxer.getStats();
+        assert.strictEqual(muxStats.framesWritten, 10);
+        assert.strictEqual(muxStats.bytesCopiedIn, 10000);
+        assert.ok(muxStats.bytesWritten >= output.length);
+        assert.ok(muxStats.writerChunks >= 1);
+
+        console.log('✓ Stats test passed');
+    }
+
+    async testWebMFramePool() {
+        console.log('Testing WebM frame buffer recycling...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+
+        for (let i = 0; i < file.getTrackCount(); i++) {
+            const trackInfo = file.getTrackInfo(i);
+            const isVideo = trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO;
+            const read = (parser) => isVideo
+                ? parser.readNextVideoFrame(trackInfo.trackNumber)
+                : parser.readNextAudioFrame(trackInfo.trackNumber);
+
+            // Released buffers are reused, so every frame must still carry
+            // its own payload
+            let frames = 0;
+            let frame;
+            while ((frame = read(file.parser)) !== null) {
+                const expected = read(reference.parser);
+                assert.ok(Buffer.from(frame.data).equals(Buffer.from(expected.data)),
+                    'Recycled buffers should hold the right payload');
+                frame.release();
+                expected.release();
+                frames++;
+            }
+            assert.ok(frames > 0);
+        }
+
+        if (this.libwebm.statsEnabled) {
+            const stats = file.parser.getStats();
+            assert.ok(stats.allocations < stats.framesReturned / 2,
+                'Most frames should reuse a pooled buffer');
+        }
+
+        console.log('✓ Frame pool test passed');
+    }
+
+    async testWebMBatchProbe() {
+        console.log('Testing WebM batch metadata probe...');
+
+        const sample = fs.readFileSync(this.sampleWebMPath);
+        const av1 = fs.readFileSync(this.av1OpusWebMPath);
+        const prober = this.libwebm.WebMProber();
+        const results = prober.probe([
+            sample,
+            { data: av1.subarray(0, 64 * 1024), size: av1.length },
+            { data: av1.subarray(0, 16), size: av1.length },
+            new Uint8Array(1024)
+        ], { threadCount: 2 });
+        assert.strictEqual(results.length, 4);
+
+        // Header-only probes agree with a full parse
+        for (const [result, buffer] of [[results[0], sample], [results[1], av1]]) {
+            const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+            assert.strictEqual(result.status, this.libwebm.WebMErrorCode.SUCCESS);
+            assert.strictEqual(result.truncated, false);
+            assert.strictEqual(result.durationNs / 1e9, file.getDuration());
+            assert.strictEqual(result.tracks.length, file.getTrackCount());
+            result.tracks.forEach((track, i) => {
+                const info = file.getTrackInfo(i);
+                assert.strictEqual(track.trackNumber, info.trackNumber);
+                assert.strictEqual(track.codecId, info.codecId);
+                if (info.trackType === this.libwebm.WebMTrackType.VIDEO) {
+                    assert.strictEqual(track.video.width, file.parser.getVideoInfo(info.trackNumber).width);
+                } else if (info.trackType === this.libwebm.WebMTrackType.AUDIO) {
+                    assert.strictEqual(track.audio.channels, file.parser.getAudioInfo(info.trackNumber).channels);
+                }
+            });
+        }
+
+        assert.strictEqual(results[2].truncated, true, 'A 16-byte prefix cannot hold the headers');
+        assert.notStrictEqual(results[3].status, this.libwebm.WebMErrorCode.SUCCESS, 'Zeroes are not WebM');
+
+        console.log('✓ Batch probe test passed');
+    }
+
+    async testWebMParserReset() {
+        console.log('Testing WebM parser and muxer reuse...');
+
+        const readAll = (file) => {
+            const frames = [];
+            for (let i = 0; i < file.getTrackCount(); i++) {
+                const trackInfo = file.getTrackInfo(i);
+                const isVideo = trackInfo.trackType === this.libwebm.WebMTrackType.VIDEO;
+                let frame;
+                while ((frame = isVideo
+                    ? file.parser.readNextVideoFrame(trackInfo.trackNumber)
+                    : file.parser.readNextAudioFrame(trackInfo.trackNumber)) !== null) {
+                    frames.push([trackInfo.trackNumber, Number(frame.timestampNs), frame.data.length]);
+                }
+            }
+            return frames;
+        };
+
+        // One parser walks several files and matches fresh parsers on each
+        const sample = fs.readFileSync(this.sampleWebMPath);
+        const av1 = fs.readFileSync(this.av1OpusWebMPath);
+        const reused = await this.libwebm.WebMFile.fromBuffer(sample, this.libwebm._module);
+        reused.parser.buildIndex();
+        readAll(reused);
+        for (const buffer of [av1, sample, av1]) {
+            reused.parser.reset(buffer);
+            reused.parser.parseHeaders();
+            const fresh = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+            assert.strictEqual(reused.getTrackCount(), fresh.getTrackCount());
+            assert.strictEqual(reused.getDuration(), fresh.getDuration());
+            assert.deepStrictEqual(readAll(reused), readAll(fresh), 'Reused parser should read the same frames');
+        }
+
+        // Rebinding to a source works the same way
+        const fd = fs.openSync(this.sampleWebMPath, 'r');
+        try {
+            reused.parser.rebind(this.libwebm.WebMSources.fromFileDescriptor(fs, fd), { blockSize: 4096 });
+            reused.parser.parseHeaders();
+            const fresh = await this.libwebm.WebMFile.fromBuffer(sample, this.libwebm._module);
+            assert.deepStrictEqual(readAll(reused), readAll(fresh), 'Rebound parser should read the source');
+        } finally {
+            fs.closeSync(fd);
+        }
+
+        // A reset muxer starts a new, independent file
+        const file = this.libwebm.WebMFile.forWriting(this.libwebm._module);
+        const writeFile = (frameCount) => {
+            const videoTrack = file.muxer.addVideoTrack(320, 240, 'V_VP8');
+            for (let i = 0; i < frameCount; i++) {
+                file.muxer.writeVideoFrame(videoTrack, new Uint8Array(500), i * 33333333, i === 0);
+            }
+            return file.muxer.finalize();
+        };
+        const first = writeFile(10);
+        file.muxer.reset();
+        const second = writeFile(4);
+        for (const [output, frameCount] of [[first, 10], [second, 4]]) {
+            const parsed = await this.libwebm.WebMFile.fromBuffer(output, this.libwebm._module);
+            assert.strictEqual(parsed.getTrackCount(), 1, 'Reset muxer should not keep old tracks');
+            assert.strictEqual(readAll(parsed).length, frameCount);
+        }
+
+        console.log('✓ Parser reset test passed');
+    }
+
+    async testWebMWorkerPool() {
+        console.log('Testing WebM worker pool...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const expected = new Map();
+        for (let i = 0; i < reference.getTrackCount(); i++) {
+            const trackNumber = reference.getTrackInfo(i).trackNumber;
+            const timestamps = [];
+            let batch;
+            while ((batch = reference.parser.readFrames(trackNumber, 256)).count > 0) {
+                timestamps.push(...batch.timestampsNs);
+            }
+            expected.set(trackNumber, timestamps);
+        }
+
+        const pool = await this.libwebm.createWorkerPool({ workers: 2 });
+        try {
+            assert.strictEqual(pool.size, 2);
+
+            // The input is transferred, not copied
+            const input = new Uint8Array(buffer).buffer;
+            const whole = await pool.demux(input);
+            assert.strictEqual(input.byteLength, 0, 'Input should be transferred to the worker');
+            assert.strictEqual(whole.tracks.length, reference.getTrackCount());
+            for (const track of whole.frames) {
+                assert.deepStrictEqual(Array.from(track.timestampsNs), expected.get(track.trackNumber));
+                const last = track.count - 1;
+                assert.strictEqual(track.offsets[last] + track.sizes[last], track.data.length);
+            }
+
+            // Ranges split the frames without losing or repeating any
+            const shared = new Uint8Array(new SharedArrayBuffer(buffer.length));
+            shared.set(buffer);
+            const ranges = await pool.demuxRanges(shared, { ranges: 3 });
+            assert.strictEqual(ranges.length, 3);
+            for (const [trackNumber, timestamps] of expected) {
+                const joined = ranges.flatMap((range) => Array.from(
+                    range.frames.find((track) => track.trackNumber === trackNumber).timestampsNs));
+                assert.deepStrictEqual(joined, timestamps, 'Ranges should cover every frame once');
+            }
+
+            // Concurrent remux jobs are spread over the workers
+            const remuxed = await Promise.all([0, 1, 2].map(() => pool.remux(shared)));
+            for (const { data, frameCount } of remuxed) {
+                const file = await this.libwebm.WebMFile.fromBuffer(data, this.libwebm._module);
+                assert.strictEqual(file.getTrackCount(), reference.getTrackCount());
+                assert.ok(frameCount > 0);
+            }
+
+            await assert.rejects(pool.demux(new Uint8Array(1024)), 'Invalid input should reject the job');
+        } finally {
+            pool.terminate();
+        }
+
+        console.log('✓ Worker pool test passed');
+    }
+
+    async testWebMFrameIterator() {
+        console.log('Testing async WebM frame iterator...');
+
+        const buffer = fs.readFileSync(this.sampleWebMPath);
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const expected = [];
+        let batch;
+        while ((batch = reference.parser.readFrames(1, 256)).count > 0) {
+            expected.push(...batch.timestampsNs);
+        }
+
+        const collect = async (parser, options = {}) => {
+            const batches = [];
+            for await (const frames of parser.frames({ track: 1, batchSize: 100000, ...options })) {
+                batches.push(Array.from(frames.timestampsNs));
+            }
+            return batches;
+        };
+
+        // One batch per cluster, block walk and index alike
+        const walked = await collect((await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module)).parser);
+        assert.deepStrictEqual(walked.flat(), expected, 'Iterator should return every frame');
+        assert.ok(walked.length > 1, 'Batches should end at cluster boundaries');
+        const indexedFile = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        indexedFile.parser.buildIndex();
+        assert.deepStrictEqual(await collect(indexedFile.parser), walked, 'Indexed batches should match');
+
+        // Nothing is read while the consumer holds reading back
+        const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        let reads = 0;
+        let consumed = 0;
+        for await (const frames of file.parser.frames({
+            track: 1,
+            batchSize: 4,
+            ready: () => {
+                assert.strictEqual(reads, consumed, 'Reads should wait for the consumer');
+                reads++;
+                return new Promise((resolve) => setImmediate(resolve));
+            }
+        })) {
+            assert.ok(frames.count <= 4);
+            consumed++;
+        }
+
+        // A streaming parser waits for chunks instead of ending early
+        const parser = this.libwebm.WebMParser.createStreaming();
+        const streamed = collect(parser);
+        for (let offset = 0; offset < buffer.length; offset += 4096) {
+            await new Promise((resolve) => setImmediate(resolve));
+            parser.appendData(buffer.subarray(offset, offset + 4096));
+        }
+        parser.endOfStream();
+        assert.deepStrictEqual((await streamed).flat(), expected, 'Streamed frames should all arrive');
+
+        console.log('✓ Frame iterator test passed');
+    }
+
+    async testWebMCodecsBridge() {
+        console.log('Testing WebCodecs bridge...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        let videoTrack = null;
+        for (let i = 0; i < file.getTrackCount(); i++) {
+            const info = file.getTrackInfo(i);
+            const config = file.parser.getDecoderConfig(info.trackNumber);
+            if (info.codecId === 'V_AV01') {
+                videoTrack = info.trackNumber;
+                assert.match(config.codec, /^av01\.\d\.\d\d[MH]\.\d\d$/);
+                assert.strictEqual(config.codedWidth, file.parser.getVideoInfo(info.trackNumber).width);
+            } else if (info.codecId === 'A_OPUS') {
+                assert.strictEqual(config.codec, 'opus');
+                assert.strictEqual(config.numberOfChannels, file.parser.getAudioInfo(info.trackNumber).channels);
+                assert.strictEqual(Buffer.from(config.description.subarray(0, 8)).toString(), 'OpusHead');
+            }
+        }
+        assert.ok(videoTrack !== null, 'Sample should have an AV1 track');
+
+        // Chunk inits carry microsecond timestamps and the frame payload
+        const first = file.parser.readNextChunk(videoTrack);
+        const expected = reference.parser.readNextVideoFrame(videoTrack);
+        assert.strictEqual(first.type, 'key');
+        assert.strictEqual(first.timestamp, Math.trunc(Number(expected.timestampNs) / 1000));
+        assert.ok(Buffer.from(first.data).equals(Buffer.from(expected.data)));
+
+        // Chunks and keyframes of a source-backed parser outlive the next
+        // reads, which recycle its cache blocks
+        const fd = fs.openSync(this.av1OpusWebMPath, 'r');
+        try {
+            const sourced = await this.libwebm.WebMFile.fromSource(
+                this.libwebm.WebMSources.fromFileDescriptor(fs, fd), this.libwebm._module,
+                { blockSize: 4096, cacheBlocks: 1 });
+            const sourcedChunks = [];
+            for (let i = 0; i < 8; i++) {
+                sourcedChunks.push(sourced.parser.readNextChunk(videoTrack));
+            }
+            const sourcedKeyframe = sourced.parser.readNextKeyframe(videoTrack);
+            sourced.parser.readNextChunk(videoTrack);
+            const bufferParser = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+            for (const chunk of sourcedChunks) {
+                const reread = bufferParser.parser.readNextChunk(videoTrack);
+                assert.ok(Buffer.from(chunk.data).equals(Buffer.from(reread.data)),
+                    'Source-backed chunk data should not change on later reads');
+            }
+            const keyframe = bufferParser.parser.readNextKeyframe(videoTrack);
+            assert.ok(Buffer.from(sourcedKeyframe.data).equals(Buffer.from(keyframe.data)),
+                'Source-backed keyframe data should not change on later reads');
+        } finally {
+            fs.closeSync(fd);
+        }
+
+        // Bad tracks fail with a clear error rather than a TypeError
+        const drainChunks = async (options) => {
+            for await (const chunk of reference.parser.chunks(options)) {
+                assert.ok(chunk);
+            }
+        };
+        await assert.rejects(drainChunks({}), /chunks\(\) needs a track number/);
+        await assert.rejects(drainChunks({ track: 999 }), /not found/);
+
+        // Round trip through the muxer with chunks shaped like WebCodecs output
+        const iterated = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const muxer = this.libwebm.WebMMuxer();
+        const outputTrack = muxer.addTrackFromConfig(iterated.parser.getDecoderConfig(videoTrack));
+        const timestamps = [];
+        for await (const chunk of iterated.parser.chunks({ track: videoTrack })) {
+            const data = chunk.data.slice();
+            muxer.writeChunk(outputTrack, {
+                type: chunk.type,
+                timestamp: chunk.timestamp,
+                byteLength: data.length,
+                copyTo: (destination) => destination.set(data)
+            });
+            timestamps.push(chunk.timestamp);
+        }
+        const output = await this.libwebm.WebMFile.fromBuffer(muxer.finalize(), this.libwebm._module);
+        assert.strictEqual(output.getTrackInfo(0).codecId, 'V_AV01');
+        assert.ok(Buffer.from(output.parser.getCodecPrivate(1)).equals(Buffer.from(file.parser.getCodecPrivate(videoTrack))),
+            'The description should become the CodecPrivate');
+        const written = [];
+        let chunk;
+        while ((chunk = output.parser.readNextChunk(1)) !== null) {
+            written.push(chunk.timestamp);
+        }
+        assert.deepStrictEqual(written, timestamps);
+
+        // Opus encoder configs usually come without a description
+        const audioMuxer = this.libwebm.WebMMuxer();
+        const audioTrack = audioMuxer.addTrackFromConfig({ codec: 'opus', sampleRate: 48000, numberOfChannels: 2 });
+        audioMuxer.writeChunk(audioTrack, { type: 'key', timestamp: 0, byteLength: 3, copyTo: (d) => d.set([1, 2, 3]) });
+        const audio = await this.libwebm.WebMFile.fromBuffer(audioMuxer.finalize(), this.libwebm._module);
+        assert.strictEqual(Buffer.from(audio.parser.getCodecPrivate(1).subarray(0, 8)).toString(), 'OpusHead');
+
+        console.log('✓ WebCodecs bridge test passed');
+    }
+
+    async testWebMIndexBlob() {
+        console.log('Testing WebM serialized frame index...');
+
+        const buffer = fs.readFileSync(this.sampleWebMPath);
+        const indexed = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        indexed.parser.buildIndex();
+        const blob = indexed.parser.exportIndex();
+        const frameCount = indexed.parser.getIndexedFrameCount(1);
+        assert.ok(frameCount > 0);
+        assert.ok(blob.length < frameCount * 16, `Index blob should be compact (${blob.length} bytes)`);
+
+        const readAll = (parser) => {
+            const frames = [];
+            let batch;
+            while ((batch = parser.readFrames(1, 256)).count > 0) {
+                for (let i = 0; i < batch.count; i++) {
+                    frames.push([batch.timestampsNs[i], batch.sizes[i], batch.flags[i]]);
+                }
+            }
+            return frames;
+        };
+
+        // A lazily opened parser with the blob reads the same frames
+        const reopened = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module,
+            { lazy: true, index: blob });
+        assert.strictEqual(reopened.parser.getIndexedFrameCount(1), frameCount);
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        assert.deepStrictEqual(readAll(reopened.parser), readAll(reference.parser));
+
+        // Damaged blobs and blobs of other files are rejected
+        const damaged = blob.slice();
+        damaged[Math.floor(damaged.length / 2)] ^= 0xFF;
+        const target = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module, { lazy: true });
+        assert.throws(() => target.parser.importIndex(damaged), /Failed to load frame index/);
+        const other = await this.libwebm.WebMFile.fromBuffer(fs.readFileSync(this.av1OpusWebMPath), this.libwebm._module);
+        assert.throws(() => other.parser.importIndex(blob), /another file/);
+
+        console.log('✓ Index blob test passed');
+    }
+
+    async testWebMModuleVariants() {
+        console.log('Testing WebM module variants and precompiled instantiation...');
+
+        const buffer = fs.readFileSync(this.sampleWebMPath);
+
+        // A parser-only module (or the full one when it was not built) parses
+        const parserOnly = await createLibWebM({ parts: 'parser', simd: false });
+        assert.ok(parserOnly.hasParser);
+        const parser = parserOnly.WebMParser.createFromBuffer(buffer);
+        parser.parseHeaders();
+        assert.ok(parser.getTrackCount() > 0);
+        if (!parserOnly.hasMuxer) {
+            assert.throws(() => parserOnly.WebMMuxer(), /WebMMuxer is not available/);
+        }
+        await assert.rejects(createLibWebM({ parts: 'demuxer' }), /Unknown module parts/);
+
+        // An explicitly imported factory skips the variant lookup
+        const { default: baselineFactory } = await import('../dist/libwebm.js');
+        const explicit = await createLibWebM({ moduleFactory: baselineFactory });
+        assert.ok(explicit.hasParser && explicit.hasMuxer);
+
+        // A precompiled WebAssembly.Module is instantiated without compiling again
+        const wasm = fs.readFileSync(new URL('../dist/libwebm.wasm', import.meta.url));
+        const compiled = await WebAssembly.compile(wasm);
+        const first = await createLibWebM({ simd: false, wasmModule: compiled });
+        const second = await createLibWebM({ simd: false, wasmModule: first.wasmModule });
+        assert.strictEqual(second.wasmModule, compiled);
+        const reparsed = second.WebMParser.createFromBuffer(buffer);
+        reparsed.parseHeaders();
+        assert.strictEqual(reparsed.getTrackCount(), parser.getTrackCount());
+
+        console.log('✓ Module variants test passed');
+    }
+
+    async testWebMAudioFrameTiming() {
+        console.log('Testing WebM audio frame timing across laced blocks...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const file = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+
+        for (let i = 0; i < file.getTrackCount(); i++) {
+            const trackInfo = file.getTrackInfo(i);
+            if (trackInfo.trackType !== this.libwebm.WebMTrackType.AUDIO) continue;
+
+            // Every frame of every block is returned, in presentation order
+            let frames = 0;
+            let lastTimestampNs = -1;
+            let frame;
+            while ((frame = file.parser.readNextAudioFrame(trackInfo.trackNumber)) !== null) {
+                assert.ok(frame.data.length > 0, 'Audio frame should have data');
+                assert.ok(Number(frame.timestampNs) >= lastTimestampNs, 'Audio timestamps should not go backwards');
+                lastTimestampNs = Number(frame.timestampNs);
+                frames++;
+            }
+            assert.ok(frames > 1, 'Should read every audio frame');
+        }
+
+        console.log('✓ Audio frame timing test passed');
+    }
+
+    async testWebMKeyframeReader() {
+        console.log('Testing WebM keyframe-only reader...');
+
+        // Reference list of keyframe timestamps from a full frame walk
+        const buffer = fs.readFileSync(this.sampleWebMPath);
+        const reference = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const expected = [];
+        const keyframeData = new Map();
+        let firstTimestamp = null;
+        let videoFrameCount = 0;
+        let frame;
+        while ((frame = reference.parser.readNextVideoFrame(1)) !== null) {
+            videoFrameCount++;
+            if (firstTimestamp === null) {
+                firstTimestamp = Number(frame.timestampNs);
+            }
+            if (frame.isKeyframe) {
+                expected.push(Number(frame.timestampNs));
+                keyframeData.set(Number(frame.timestampNs), Buffer.from(frame.data));
+            }
+        }
+        assert.ok(expected.length > 0, 'Sample should contain keyframes');
+
+        const collect = (parser) => {
+            const timestamps = [];
+            let keyframe;
+            while ((keyframe = parser.readNextKeyframe(1)) !== null) {
+                assert.ok(keyframe.isKeyframe, 'Only keyframes should be returned');
+                assert.ok(keyframe.data.length > 0, 'Keyframe should carry its payload');
+                timestamps.push(keyframe.timestampNs);
+            }
+            return timestamps;
+        };
+
+        // Cues, block walk and index must agree on files cued per keyframe;
+        // otherwise the cued keyframes are a subset of all of them
+        const cued = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const viaDefault = collect(cued.parser);
+        assert.ok(viaDefault.length > 0);
+        for (const timestamp of viaDefault) {
+            assert.ok(expected.includes(timestamp), `${timestamp} should be a keyframe timestamp`);
+        }
+
+        const indexed = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        indexed.parser.buildIndex();
+        assert.deepStrictEqual(collect(indexed.parser), expected, 'Indexed walk should return every keyframe');
+
+        // The regular reader keeps its own position
+        const mixed = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        mixed.parser.readNextKeyframe(1);
+        mixed.parser.readNextKeyframe(1);
+        const firstFrame = mixed.parser.readNextVideoFrame(1);
+        assert.strictEqual(Number(firstFrame.timestampNs), firstTimestamp, 'Keyframe reads should not move the frame reader');
+
+        // A fallback id resolves to the video track and shares its position
+        const aliased = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        aliased.parser.buildIndex();
+        const aliasedWalk = [aliased.parser.readNextKeyframe(1), aliased.parser.readNextKeyframe(999),
+            aliased.parser.readNextKeyframe(1)].filter(Boolean).map((keyframe) => Number(keyframe.timestampNs));
+        assert.deepStrictEqual(aliasedWalk, expected.slice(0, 3), 'Fallback id should continue the keyframe walk');
+
+        // Streaming in small chunks, mixed with frame reads: a partly
+        // appended keyframe waits for the rest, and compaction keeps the
+        // bytes the keyframe reader still needs
+        const streaming = this.libwebm.WebMParser.createStreaming();
+        const streamedKeyframes = [];
+        let streamedFrames = 0;
+        const drain = () => {
+            while (streaming.readNextVideoFrame(1)) {
+                streamedFrames++;
+            }
+            let keyframe;
+            while ((keyframe = streaming.readNextKeyframe(1)) !== null) {
+                const timestamp = Number(keyframe.timestampNs);
+                assert.ok(Buffer.from(keyframe.data).equals(keyframeData.get(timestamp)),
+                    `Streamed keyframe at ${timestamp} should carry its complete payload`);
+                streamedKeyframes.push(timestamp);
+            }
+        };
+        for (let offset = 0; offset < buffer.length; offset += 1000) {
+            streaming.appendData(buffer.subarray(offset, offset + 1000));
+            drain();
+        }
+        streaming.endOfStream();
+        drain();
+        assert.strictEqual(streamedFrames, videoFrameCount);
+        assert.deepStrictEqual(streamedKeyframes, expected, 'Streaming walk should return every keyframe');
+
+        console.log('✓ Keyframe reader test passed');
+    }
+
+    async testWebMResilientParsing() {
+        console.log('Testing resilient WebM parsing of a damaged file...');
+
+        const original = fs.readFileSync(this.sampleWebMPath);
+        const clusterStarts = [];
+        for (let i = original.indexOf(Buffer.from([0x1F, 0x43, 0xB6, 0x75])); i >= 0;
+            i = original.indexOf(Buffer.from([0x1F, 0x43, 0xB6, 0x75]), i + 4)) {
+            clusterStarts.push(i);
+        }
+        assert.ok(clusterStarts.length >= 3, 'Sample should have several clusters');
+
+        const readAll = (parser) => {
+            const frames = [];
+            let frame;
+            while ((frame = parser.readNextVideoFrame(1)) !== null) {
+                frames.push({ timestampNs: Number(frame.timestampNs), size: frame.data.length });
+            }
+            return frames;
+        };
+
+        // An intact file parses the same way in resilient mode
+        const reference = readAll((await this.libwebm.WebMFile.fromBuffer(original, this.libwebm._module)).parser);
+        const intact = await this.libwebm.WebMFile.fromBuffer(original, this.libwebm._module, { resilient: true });
+        assert.deepStrictEqual(readAll(intact.parser), reference, 'Resilient mode should not change intact files');
+        assert.strictEqual(intact.parser.getParseErrors().length, 0);
+
+        // Wipe the start of a middle cluster's contents
+        const damaged = Buffer.from(original);
+        const target = clusterStarts[1];
+        damaged.fill(0, target + 12, target + 64);
+
+        const file = await this.libwebm.WebMFile.fromBuffer(damaged, this.libwebm._module, { resilient: true });
+        const frames = readAll(file.parser);
+        const errors = file.parser.getParseErrors();
+        assert.ok(errors.length > 0, 'Damage should be reported');
+        assert.strictEqual(errors[0].code, this.libwebm.WebMErrorCode.CORRUPTED_DATA);
+        assert.ok(errors[0].position >= target, 'Error should point into the damaged cluster');
+
+        assert.ok(frames.length > 0 && frames.length < reference.length, 'Only the damaged frames should be lost');
+        assert.strictEqual(frames[frames.length - 1].timestampNs, reference[reference.length - 1].timestampNs,
+            'Parsing should resume at the next cluster');
+        for (const frame of frames) {
+            assert.ok(reference.some(r => r.timestampNs === frame.timestampNs && r.size === frame.size),
+                'Every returned frame should be a real frame of the file');
+        }
+
+        // buildIndex() keeps the resilient index instead of replacing it
+        const indexed = await this.libwebm.WebMFile.fromBuffer(damaged, this.libwebm._module, { resilient: true });
+        const indexedCount = indexed.parser.getIndexedFrameCount(1);
+        assert.ok(indexedCount > 0);
+        indexed.parser.buildIndex();
+        indexed.parser.buildIndexParallel(0);
+        assert.strictEqual(indexed.parser.getIndexedFrameCount(1), indexedCount);
+        assert.deepStrictEqual(readAll(indexed.parser), frames, 'Reads should survive buildIndex()');
+
+        // remux() reads the surviving frames from the resilient index
+        const source = await this.libwebm.WebMFile.fromBuffer(damaged, this.libwebm._module, { resilient: true });
+        const muxer = this.libwebm.WebMMuxer();
+        assert.strictEqual(muxer.remux(source.parser, { tracks: [1] }), frames.length,
+            'Remux should copy every surviving frame');
+        const remuxed = await this.libwebm.WebMFile.fromBuffer(muxer.finalize(), this.libwebm._module);
+        assert.strictEqual(readAll(remuxed.parser).length, frames.length);
+
+        console.log('✓ Resilient parsing test passed');
+    }
+
     // === MUXER TESTS ===
 
     async testWebMMuxerCreation() {
@@ -809,6 +1940,274 @@ class LibWebMTests {
         console.log('✓ Error handling test passed');
     }
 
+    async testWebMMuxerStagedFrames() {
+        console.log('Testing WebM muxer staged frames...');
+
+        const muxer = this.libwebm.WebMMuxer();
+        const videoTrack = muxer.addVideoTrack(320, 240, 'V_VP8');
+
+        const sizes = [1500, 700, 2300];
+        for (let i = 0; i < sizes.length; i++) {
+            const view = muxer.getFrameBuffer(sizes[i]);
+            assert.strictEqual(view.length, sizes[i], 'Staging view should match requested size');
+            view.fill(i + 1);
+            muxer.commitFrame(videoTrack, sizes[i], i * 33333333, i === 0);
+        }
+
+        assert.throws(() => muxer.commitFrame(999, 10, 100000000, false), 'Invalid track should throw');
+        assert.throws(() => muxer.getFrameBuffer(0), 'Empty frame buffer should throw');
+
+        const webmData = muxer.finalize();
+
+        const parsed = await this.libwebm.WebMFile.fromBuffer(webmData, this.libwebm._module);
+        for (let i = 0; i < sizes.length; i++) {
+            const frame = parsed.parser.readNextVideoFrame(videoTrack);
+            assert.ok(frame, `Frame ${i} should be readable`);
+            assert.strictEqual(frame.data.length, sizes[i], 'Frame size should round-trip');
+            assert.ok(frame.data.every(b => b === i + 1), 'Frame payload should round-trip');
+        }
+
+        console.log('✓ Muxer staged frames test passed');
+    }
+
+    async testWebMMuxerLargeOutput() {
+        console.log('Testing WebM muxer output across buffer chunks...');
+
+        // 48 frames of 256 KiB span several growing output chunks; the hinted
+        // muxer writes the same stream into a single reserved buffer
+        const frameSize = 256 * 1024;
+        const frameCount = 48;
+        const outputs = [];
+        for (const options of [{}, { expectedSize: frameSize * frameCount * 2 }]) {
+            const muxer = this.libwebm.WebMMuxer(options);
+            const videoTrack = muxer.addVideoTrack(640, 480, 'V_VP9');
+            for (let i = 0; i < frameCount; i++) {
+                const frame = new Uint8Array(frameSize).fill(i & 0xff);
+                muxer.writeVideoFrame(videoTrack, frame, i * 33333333, i % 12 === 0);
+            }
+            outputs.push(muxer.finalize());
+            if (this.libwebm.statsEnabled) {
+                // Geometric growth from a small first chunk: a handful of
+                // chunks for 12 MiB, one when the size was hinted
+                const chunks = muxer.getStats().writerChunks;
+                assert.ok(options.expectedSize ? chunks === 1 : chunks > 1 && chunks <= 12,
+                    `Unexpected output chunk count ${chunks}`);
+            }
+        }
+
+        // The output is a copy: later calls and writes do not touch it
+        const again = this.libwebm.WebMMuxer();
+        const againTrack = again.addVideoTrack(320, 240, 'V_VP8');
+        again.writeVideoFrame(againTrack, new Uint8Array(100), 0, true);
+        const before = again.getData();
+        const snapshot = before.slice();
+        again.writeVideoFrame(againTrack, new Uint8Array(100).fill(7), 33333333, false);
+        again.finalize().fill(0);
+        assert.ok(Buffer.from(before).equals(Buffer.from(snapshot)), 'getData() should return a stable copy');
+
+        for (const output of outputs) {
+            assert.ok(output.length > frameSize * frameCount, 'Output should hold every frame');
+
+            const parsed = await this.libwebm.WebMFile.fromBuffer(output, this.libwebm._module);
+            let count = 0;
+            let frame;
+            while ((frame = parsed.parser.readNextVideoFrame(1)) !== null) {
+                assert.strictEqual(frame.data.length, frameSize);
+                assert.strictEqual(frame.data[frameSize - 1], count & 0xff, 'Frame payload should survive chunk boundaries');
+                count++;
+            }
+            assert.strictEqual(count, frameCount, 'Every frame should read back');
+        }
+
+        console.log('✓ Muxer large output test passed');
+    }
+
+    async testWebMMuxerLiveDrain() {
+        console.log('Testing WebM live muxer draining...');
+
+        const muxer = this.libwebm.WebMMuxer({ live: true });
+        const videoTrack = muxer.addVideoTrack(320, 240, 'V_VP8');
+
+        const parts = [];
+        const frameCount = 90;
+        for (let i = 0; i < frameCount; i++) {
+            muxer.writeVideoFrame(videoTrack, new Uint8Array(4096).fill(i & 0xff), i * 33333333, i % 30 === 0);
+            if (i % 10 === 9) {
+                parts.push(muxer.drain());
+            }
+        }
+        assert.ok(parts.some(part => part.length > 0), 'Output should be drained before finalize');
+        assert.throws(() => muxer.setLiveMode(false), 'Mode cannot change after frames are written');
+        parts.push(muxer.finalize());
+
+        const total = parts.reduce((sum, part) => sum + part.length, 0);
+        const webmData = new Uint8Array(total);
+        let offset = 0;
+        for (const part of parts) {
+            webmData.set(part, offset);
+            offset += part.length;
+        }
+
+        const parsed = await this.libwebm.WebMFile.fromBuffer(webmData, this.libwebm._module);
+        let count = 0;
+        while (parsed.parser.readNextVideoFrame(videoTrack) !== null) {
+            count++;
+        }
+        assert.strictEqual(count, frameCount, 'Concatenated drains should hold every frame');
+
+        const fileMuxer = this.libwebm.WebMMuxer();
+        assert.throws(() => fileMuxer.drain(), 'drain() should require live mode');
+
+        console.log('✓ Live muxer drain test passed');
+    }
+
+    async testWebMMuxerClusterAndCueSettings() {
+        console.log('Testing WebM muxer cluster and cue settings...');
+
+        const muxer = this.libwebm.WebMMuxer();
+        const videoTrack = muxer.addVideoTrack(320, 240, 'V_VP8');
+        const audioTrack = muxer.addAudioTrack(48000, 2, 'A_OPUS');
+        muxer.setMaxClusterDuration(500000000);
+        muxer.setMaxClusterSize(64 * 1024);
+        muxer.setAccurateClusterDuration(true);
+        muxer.setCuesTrack(videoTrack);
+        muxer.setCuesFirst(true);
+        assert.throws(() => muxer.setCuesTrack(999), 'Unknown cues track should throw');
+
+        for (let i = 0; i < 60; i++) {
+            const timestampNs = i * 33333333;
+            muxer.writeVideoFrame(videoTrack, new Uint8Array(2000).fill(i & 0xff), timestampNs, i % 15 === 0);
+            muxer.writeAudioFrame(audioTrack, new Uint8Array(200), timestampNs);
+        }
+        assert.throws(() => muxer.setMaxClusterSize(0), 'Settings are fixed once frames are written');
+
+        const webmData = muxer.finalize();
+
+        // Cues (0x1C53BB6B) must come before the first Cluster (0x1F43B675)
+        const findId = (bytes, id) => {
+            for (let i = 0; i + 3 < bytes.length; i++) {
+                if (bytes[i] === id[0] && bytes[i + 1] === id[1] && bytes[i + 2] === id[2] && bytes[i + 3] === id[3]) {
+                    return i;
+                }
+            }
+            return -1;
+        };
+        const cuesPos = findId(webmData, [0x1C, 0x53, 0xBB, 0x6B]);
+        const clusterPos = findId(webmData, [0x1F, 0x43, 0xB6, 0x75]);
+        assert.ok(cuesPos > 0 && cuesPos < clusterPos, 'Cues should be written before the clusters');
+
+        const parsed = await this.libwebm.WebMFile.fromBuffer(webmData, this.libwebm._module);
+        let count = 0;
+        while (parsed.parser.readNextVideoFrame(videoTrack) !== null) {
+            count++;
+        }
+        assert.strictEqual(count, 60, 'All video frames should survive the Cues move');
+
+        // 2 s of frames with a 0.5 s limit must span several clusters
+        parsed.parser.seek(1500000000, videoTrack);
+        const frame = parsed.parser.readNextVideoFrame(videoTrack);
+        assert.ok(frame && frame.timestampNs <= 1500000000, 'Seek should land at or before the target');
+
+        // A reserve that fits takes the Cues in place, one too small falls
+        // back to the rewrite; both keep the SeekHead and seeking intact
+        const muxReserved = (reserve) => {
+            const reserved = this.libwebm.WebMMuxer();
+            const track = reserved.addVideoTrack(320, 240, 'V_VP8');
+            reserved.setMaxClusterDuration(500000000);
+            reserved.setCuesReserve(reserve);
+            for (let i = 0; i < 60; i++) {
+                reserved.writeVideoFrame(track, new Uint8Array(2000).fill(i & 0xff), i * 33333333, i % 15 === 0);
+            }
+            assert.throws(() => reserved.setCuesReserve(1024), 'The reserve is fixed once frames are written');
+            return reserved.finalize().slice();
+        };
+        for (const reserve of [4096, 16]) {
+            const reservedData = muxReserved(reserve);
+            const reservedCues = findId(reservedData, [0x1C, 0x53, 0xBB, 0x6B]);
+            assert.ok(reservedCues > 0 && reservedCues < findId(reservedData, [0x1F, 0x43, 0xB6, 0x75]),
+                `Cues should come before the clusters with a ${reserve} byte reserve`);
+            const reparsed = await this.libwebm.WebMFile.fromBuffer(reservedData, this.libwebm._module);
+            let reservedCount = 0;
+            while (reparsed.parser.readNextVideoFrame(1) !== null) {
+                reservedCount++;
+            }
+            assert.strictEqual(reservedCount, 60, `All frames should survive a ${reserve} byte reserve`);
+            reparsed.parser.seek(1500000000, 1);
+            const seeked = reparsed.parser.readNextVideoFrame(1);
+            assert.ok(seeked && seeked.timestampNs <= 1500000000 && seeked.timestampNs > 0,
+                `Seek should use the Cues with a ${reserve} byte reserve`);
+        }
+        assert.throws(() => this.libwebm.WebMMuxer({ live: true }).setCuesReserve(4096), 'Live mode cannot reserve Cues');
+
+        // The rewritten output keeps counting once the muxer is reused
+        if (this.libwebm.statsEnabled) {
+            muxer.reset();
+            const track = muxer.addVideoTrack(320, 240, 'V_VP8');
+            muxer.writeVideoFrame(track, new Uint8Array(2000), 0, true);
+            const reused = muxer.finalize();
+            assert.ok(muxer.getStats().bytesWritten >= reused.length, 'Writes after a Cues move should be counted');
+        }
+
+        // Leaving live mode does not undo setOutputCues(false)
+        const noCues = this.libwebm.WebMMuxer();
+        const noCuesTrack = noCues.addVideoTrack(320, 240, 'V_VP8');
+        noCues.setOutputCues(false);
+        noCues.setLiveMode(true);
+        noCues.setLiveMode(false);
+        for (let i = 0; i < 30; i++) {
+            noCues.writeVideoFrame(noCuesTrack, new Uint8Array(500), i * 33333333, i % 15 === 0);
+        }
+        assert.strictEqual(findId(noCues.finalize(), [0x1C, 0x53, 0xBB, 0x6B]), -1, 'Cues should stay disabled');
+
+        console.log('✓ Muxer cluster and cue settings test passed');
+    }
+
+    async testWebMRemux() {
+        console.log('Testing native WebM remux...');
+
+        const buffer = fs.readFileSync(this.av1OpusWebMPath);
+        const source = await this.libwebm.WebMFile.fromBuffer(buffer, this.libwebm._module);
+        const durationNs = source.getDuration() * 1e9;
+
+        // Full copy keeps every frame of every track
+        const copy = this.libwebm.WebMMuxer();
+        const copied = copy.remux(source.parser);
+        assert.ok(copied > 0, 'Remux should copy frames');
+        const copyFile = await this.libwebm.WebMFile.fromBuffer(copy.finalize(), this.libwebm._module);
+        assert.strictEqual(copyFile.getTrackCount(), source.getTrackCount(), 'Remux should keep every track');
+        for (let i = 0; i < source.getTrackCount(); i++) {
+            assert.strictEqual(copyFile.getTrackInfo(i).codecId, source.getTrackInfo(i).codecId);
+        }
+
+        // Trim to the middle third of the file, video only
+        let videoTrack = -1;
+        for (let i = 0; i < source.getTrackCount(); i++) {
+            const info = source.getTrackInfo(i);
+            if (info.trackType === this.libwebm.WebMTrackType.VIDEO) {
+                videoTrack = info.trackNumber;
+            }
+        }
+        assert.ok(videoTrack > 0, 'Sample should have a video track');
+
+        const clip = this.libwebm.WebMMuxer();
+        const clipped = clip.remux(source.parser, {
+            startNs: durationNs / 3,
+            endNs: (durationNs * 2) / 3,
+            tracks: [videoTrack]
+        });
+        assert.ok(clipped > 0 && clipped < copied, 'Trimmed remux should copy a subset of frames');
+
+        const clipFile = await this.libwebm.WebMFile.fromBuffer(clip.finalize(), this.libwebm._module);
+        assert.strictEqual(clipFile.getTrackCount(), 1, 'Only the selected track should be written');
+        const first = clipFile.parser.readNextVideoFrame(1);
+        assert.ok(first && first.isKeyframe, 'Clip should start on a keyframe');
+        assert.strictEqual(Number(first.timestampNs), 0, 'Clip should be rebased to zero');
+
+        assert.throws(() => clip.remux(source.parser), 'remux() needs a fresh muxer');
+
+        console.log('✓ Native remux test passed');
+    }
+
     // === ROUND TRIP TESTS ===
 
     async testWebMRoundTrip() {